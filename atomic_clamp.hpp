@@ -1,13 +1,16 @@
 #ifndef ATOMIC_CLAMP_HPP
 #define ATOMIC_CLAMP_HPP
 
+#include "backoff.hpp"
+
 #include <atomic>
 #include <cassert>
 #include <type_traits>
 
 namespace atomic{
 
-template <typename T, typename std::enable_if_t<std::is_arithmetic_v<T>,int> = 0>
+template <typename T, typename Backoff = backoff::None,
+    typename std::enable_if_t<std::is_arithmetic_v<T>,int> = 0>
 class Clamp{
 public:
     explicit Clamp(T init):atom_(init){}
@@ -26,6 +29,7 @@ public:
         std::memory_order failure = std::memory_order_relaxed){
         assert(low <= high);
         T cur = atom_.load(failure);
+        Backoff backoff;
         for(;;){
             if(cur < low){
                 if(atom_.compare_exchange_weak(cur, low, success, failure)){
@@ -38,6 +42,7 @@ public:
             }else{
                 return false;
             }
+            backoff();
         }
     }
 
@@ -0,0 +1,366 @@
+#ifndef ATOMIC_EPOCH_HPP
+#define ATOMIC_EPOCH_HPP
+
+#include "backoff.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+namespace atomic{
+namespace detail{
+
+// Counter written only by its owning thread and read by anyone, so updates
+// are a plain load and store instead of a locked read-modify-write.
+class OwnedCounter {
+public:
+  void add(std::size_t n) {
+    value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+  void sub(std::size_t n) {
+    value_.store(value_.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+  }
+  void set(std::size_t n) {
+    value_.store(n, std::memory_order_relaxed);
+  }
+  [[nodiscard]] std::size_t get() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<std::size_t> value_{0};
+};
+
+// Epoch-based reclamation shared by the linked queues. Owner must provide
+// (possibly as a friend) reclaim_node(Node*), orphan_local_cache(ThreadRecord*)
+// and drain_local_cache(ThreadRecord*); the local_free/local_count fields of
+// ThreadRecord are reserved for the owner's per-thread node cache, and
+// enqueued/dequeued for its per-thread operation counts. Backoff is applied
+// after a failed CAS when linking a new record.
+template <typename Owner, typename Node, typename Backoff = backoff::None>
+class EpochManager {
+public:
+  static constexpr std::size_t kCacheLine = 64;
+  static constexpr std::size_t kRetireThreshold = 64;
+
+  struct Retired {
+    Node* node;
+    uint64_t epoch;
+  };
+
+  struct alignas(kCacheLine) ThreadRecord {
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> active{false};
+    std::atomic<bool> in_use{true};
+    ThreadRecord* next{nullptr};
+    std::vector<Retired> retired;
+    Node* local_free{nullptr};
+    OwnedCounter local_count;
+    OwnedCounter retired_count;
+    OwnedCounter enqueued;
+    OwnedCounter dequeued;
+  };
+
+  EpochManager(const EpochManager&) = delete;
+  EpochManager& operator=(const EpochManager&) = delete;
+
+  explicit EpochManager(Owner* owner)
+      : owner_(owner) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    serial_ = ++reg.last_serial;
+    if (reg.free_ids.empty()) {
+      id_ = reg.managers.size();
+      reg.managers.push_back(this);
+    } else {
+      id_ = reg.free_ids.back();
+      reg.free_ids.pop_back();
+      reg.managers[id_] = this;
+    }
+  }
+  ~EpochManager() {
+    shutdown();
+    ThreadRecord* node = records_.load(std::memory_order_relaxed);
+    while (node) {
+      for (const auto& retired : node->retired) {
+        delete retired.node;
+      }
+      node->retired.clear();
+      owner_->drain_local_cache(node);
+      ThreadRecord* next = node->next;
+      delete node;
+      node = next;
+    }
+    for (const auto& retired : orphans_) {
+      delete retired.node;
+    }
+  }
+
+  // Unregisters the manager, so exiting threads stop handing their records
+  // back to it. Exiting threads release records under the registry lock,
+  // so once this returns none is in flight. The owner must call it before
+  // tearing down anything release_record() touches (e.g. its free list);
+  // the destructor calls it too. Idempotent.
+  void shutdown() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    if (!registered_) {
+      return;
+    }
+    registered_ = false;
+    reg.managers[id_] = nullptr;
+    reg.free_ids.push_back(id_);
+  }
+
+  ThreadRecord* get_record() {
+    ThreadRecord* record = find_record();
+    if (record) {
+      return record;
+    }
+    record = claim_record();
+    if (!record) {
+      record = new ThreadRecord();
+      Backoff backoff;
+      ThreadRecord* head = records_.load(std::memory_order_acquire);
+      record->next = head;
+      while (!records_.compare_exchange_weak(
+          head, record,
+          std::memory_order_release,
+          std::memory_order_relaxed)) {
+        record->next = head;
+        backoff();
+      }
+    }
+    register_record(record);
+    return record;
+  }
+
+  void retire(Node* node) {
+    ThreadRecord* record = get_record();
+    record->retired.push_back(Retired{node, global_epoch_.load(std::memory_order_relaxed)});
+    record->retired_count.set(record->retired.size());
+    if (record->retired.size() >= kRetireThreshold) {
+      scan(record);
+    }
+  }
+
+  // Visits every record, including ones released by exited threads, whose
+  // counters stay meaningful. Records live as long as the manager.
+  template <typename F>
+  void for_each_record(F&& f) const {
+    for (ThreadRecord* node = records_.load(std::memory_order_acquire); node; node = node->next) {
+      f(*node);
+    }
+  }
+
+  // Retired nodes not yet reclaimed, including those orphaned by exited threads.
+  [[nodiscard]] std::size_t retired_backlog() const {
+    std::size_t total = orphan_count_.load(std::memory_order_relaxed);
+    for_each_record([&](const ThreadRecord& record) {
+      total += record.retired_count.get();
+    });
+    return total;
+  }
+
+  class Guard {
+  public:
+    explicit Guard(EpochManager& manager)
+        : manager_(manager),
+          record_(manager_.get_record()) {
+      record_->epoch.store(manager_.global_epoch_.load(std::memory_order_acquire),
+                           std::memory_order_release);
+      record_->active.store(true, std::memory_order_release);
+      // Publish active before loading any shared pointer; pairs with the
+      // fence in advance_epoch().
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    ~Guard() {
+      record_->active.store(false, std::memory_order_release);
+    }
+
+    ThreadRecord* record() const {
+      return record_;
+    }
+
+  private:
+    EpochManager& manager_;
+    ThreadRecord* record_;
+  };
+
+private:
+  void scan(ThreadRecord* record) {
+    advance_epoch();
+    const uint64_t cur = global_epoch_.load(std::memory_order_acquire);
+
+    std::vector<Retired> remaining;
+    remaining.reserve(record->retired.size());
+    for (const auto& r : record->retired) {
+      if (is_safe(r, cur)) {
+        owner_->reclaim_node(r.node);
+      } else {
+        remaining.push_back(r);
+      }
+    }
+    record->retired.swap(remaining);
+    record->retired_count.set(record->retired.size());
+
+    if (has_orphans_.load(std::memory_order_relaxed)) {
+      adopt_orphans(cur);
+    }
+  }
+
+  // Reclaims whatever exited threads left behind once it is old enough.
+  // try_lock keeps scan() from ever blocking on another scanner.
+  void adopt_orphans(uint64_t cur) {
+    std::unique_lock<std::mutex> lock(orphan_mu_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;
+    }
+    std::vector<Retired> remaining;
+    for (const auto& r : orphans_) {
+      if (is_safe(r, cur)) {
+        owner_->reclaim_node(r.node);
+      } else {
+        remaining.push_back(r);
+      }
+    }
+    orphans_.swap(remaining);
+    orphan_count_.store(orphans_.size(), std::memory_order_relaxed);
+    has_orphans_.store(!orphans_.empty(), std::memory_order_relaxed);
+  }
+
+  // A node retired in epoch e may still be referenced by a reader pinned
+  // at e, so it is only safe once the global epoch has moved two past it.
+  static bool is_safe(const Retired& r, uint64_t cur) {
+    return r.epoch + 2 <= cur;
+  }
+
+  void advance_epoch() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const uint64_t cur = global_epoch_.load(std::memory_order_acquire);
+    ThreadRecord* node = records_.load(std::memory_order_acquire);
+    while (node) {
+      if (node->active.load(std::memory_order_acquire) &&
+          node->epoch.load(std::memory_order_acquire) != cur) {
+        return;
+      }
+      node = node->next;
+    }
+    uint64_t expected = cur;
+    global_epoch_.compare_exchange_weak(
+        expected, cur + 1,
+        std::memory_order_release,
+        std::memory_order_relaxed);
+  }
+
+  // Each live manager owns a dense id that indexes the thread-local slot
+  // table; the serial is never reused, so a slot left behind by a
+  // destroyed manager whose id was recycled is simply treated as a miss.
+  ThreadRecord* find_record() {
+    auto& slots = tls_slots().slots;
+    if (id_ < slots.size() && slots[id_].serial == serial_) {
+      return slots[id_].record;
+    }
+    return nullptr;
+  }
+
+  void register_record(ThreadRecord* record) {
+    auto& slots = tls_slots().slots;
+    if (slots.size() <= id_) {
+      slots.resize(id_ + 1);
+    }
+    slots[id_] = Slot{serial_, record};
+  }
+
+  // Records released by exited threads are handed to the next new thread
+  // instead of growing the list that advance_epoch() walks.
+  ThreadRecord* claim_record() {
+    ThreadRecord* node = records_.load(std::memory_order_acquire);
+    while (node) {
+      bool expected = false;
+      if (!node->in_use.load(std::memory_order_relaxed) &&
+          node->in_use.compare_exchange_strong(
+              expected, true,
+              std::memory_order_acquire,
+              std::memory_order_relaxed)) {
+        return node;
+      }
+      node = node->next;
+    }
+    return nullptr;
+  }
+
+  // Runs on the exiting thread: its pending retirements move to the
+  // orphan list and its cached nodes to the shared free list, so nothing
+  // stays pinned until another thread happens to claim the record.
+  void release_record(ThreadRecord* record) {
+    record->active.store(false, std::memory_order_release);
+    if (!record->retired.empty()) {
+      std::lock_guard<std::mutex> lock(orphan_mu_);
+      orphans_.insert(orphans_.end(), record->retired.begin(), record->retired.end());
+      orphan_count_.store(orphans_.size(), std::memory_order_relaxed);
+      has_orphans_.store(true, std::memory_order_relaxed);
+    }
+    std::vector<Retired>().swap(record->retired);
+    record->retired_count.set(0);
+    owner_->orphan_local_cache(record);
+    record->in_use.store(false, std::memory_order_release);
+  }
+
+  struct Slot {
+    uint64_t serial{0};
+    ThreadRecord* record{nullptr};
+  };
+
+  struct Registry {
+    std::mutex mu;
+    std::vector<EpochManager*> managers;
+    std::vector<std::size_t> free_ids;
+    uint64_t last_serial{0};
+  };
+
+  static Registry& registry() {
+    static Registry reg;
+    return reg;
+  }
+
+  struct ThreadSlots {
+    std::vector<Slot> slots;
+    ~ThreadSlots() {
+      Registry& reg = registry();
+      std::lock_guard<std::mutex> lock(reg.mu);
+      for (std::size_t id = 0; id < slots.size(); ++id) {
+        if (slots[id].serial == 0 || id >= reg.managers.size()) {
+          continue;
+        }
+        EpochManager* manager = reg.managers[id];
+        if (manager && manager->serial_ == slots[id].serial) {
+          manager->release_record(slots[id].record);
+        }
+      }
+    }
+  };
+
+  static ThreadSlots& tls_slots() {
+    thread_local ThreadSlots slots;
+    return slots;
+  }
+
+  alignas(kCacheLine) std::atomic<uint64_t> global_epoch_{0};
+  std::atomic<ThreadRecord*> records_{nullptr};
+  std::atomic<bool> has_orphans_{false};
+  std::mutex orphan_mu_;
+  std::vector<Retired> orphans_;
+  std::atomic<std::size_t> orphan_count_{0};
+  Owner* owner_{nullptr};
+  std::size_t id_{0};
+  uint64_t serial_{0};
+  bool registered_{true};
+};
+
+}
+}
+
+#endif
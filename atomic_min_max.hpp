@@ -1,12 +1,14 @@
 #ifndef ATOMIC_MIN_MAX_HPP
 #define ATOMIC_MIN_MAX_HPP
 
+#include "backoff.hpp"
+
 #include <atomic>
 #include <cmath>
 #include <type_traits>
 namespace atomic{
 
-template <typename T,
+template <typename T, typename Backoff = backoff::None,
     typename std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
 class MinMax{
 public:
@@ -31,12 +33,14 @@ public:
             }
         }
         T cur = cur_.load(failure);
+        Backoff backoff;
         for(;;){
             if constexpr (std::is_floating_point_v<T>){
                 if(std::isnan(cur)){
                     if(cur_.compare_exchange_weak(cur, v, success, failure)){
                         return true;
                     }
+                    backoff();
                     continue;
                 }
             }
@@ -47,6 +51,7 @@ public:
                 success, failure)){
                 return true;
             }
+            backoff();
         }
     }
     [[nodiscard]]bool update_max(
@@ -59,12 +64,14 @@ public:
             }
         }
         T cur = cur_.load(failure);
+        Backoff backoff;
         for(;;){
             if constexpr (std::is_floating_point_v<T>){
                 if(std::isnan(cur)){
                     if(cur_.compare_exchange_weak(cur, v, success, failure)){
                         return true;
                     }
+                    backoff();
                     continue;
                 }
             }
@@ -75,6 +82,7 @@ public:
                 success, failure)){
                 return true;
             }
+            backoff();
         }
     }
 private:
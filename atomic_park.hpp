@@ -0,0 +1,152 @@
+#ifndef ATOMIC_PARK_HPP
+#define ATOMIC_PARK_HPP
+#include "backoff.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace atomic{
+namespace detail{
+
+// Blocks while word == expected, for at most timeout_ns (< 0 means forever).
+// May return spuriously; callers always re-check their own condition.
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, int64_t timeout_ns){
+#ifdef __linux__
+    timespec ts{};
+    timespec* tsp = nullptr;
+    if(timeout_ns >= 0){
+        ts.tv_sec = static_cast<time_t>(timeout_ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(timeout_ns % 1000000000);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+        FUTEX_WAIT_PRIVATE, expected, tsp, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    if(timeout_ns < 0){
+        word.wait(expected, std::memory_order_acquire);
+        return;
+    }
+    if(word.load(std::memory_order_acquire) == expected){
+        std::this_thread::sleep_for(std::chrono::nanoseconds(
+            timeout_ns < 50000 ? timeout_ns : 50000));
+    }
+#else
+    if(word.load(std::memory_order_acquire) == expected){
+        const int64_t nap = (timeout_ns >= 0 && timeout_ns < 50000) ? timeout_ns : 50000;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nap));
+    }
+#endif
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word, int count){
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+        FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    if(count == 1){
+        word.notify_one();
+    }else{
+        word.notify_all();
+    }
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+// Registers the process for private expedited membarrier once. Returns
+// false where the kernel (or platform) has no such command.
+inline bool membarrier_ready(){
+#if defined(__linux__) && defined(SYS_membarrier)
+    static const bool ready =
+        syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    return ready;
+#else
+    return false;
+#endif
+}
+
+// Forces a full barrier on every running thread of the process, so the
+// other side of a store/load handshake can get away with a compiler-only
+// barrier. Only valid after membarrier_ready() returned true.
+inline void heavy_barrier(){
+#if defined(__linux__) && defined(SYS_membarrier)
+    syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+#endif
+}
+
+// Waiter-counted futex word. A waiter calls prepare_wait(), re-checks its
+// condition, then either cancel_wait() or commit_wait(). Producers call
+// notify_one()/notify_all() after publishing the state waiters re-check.
+// The store/load handshake between the two is asymmetric: the rare waiter
+// pays for a process-wide barrier, so a notify with nobody parked is a
+// compiler barrier and a relaxed load, and the publishing operation needs
+// no ordering beyond its own. Without membarrier both sides fall back to
+// seq_cst fences.
+class alignas(64) Parker{
+public:
+    Parker()=default;
+    Parker(const Parker&)=delete;
+    Parker& operator=(const Parker&)=delete;
+
+    [[nodiscard]] uint32_t prepare_wait(){
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        if(asymmetric_){
+            heavy_barrier();
+        }else{
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return epoch_.load(std::memory_order_acquire);
+    }
+    void cancel_wait(){
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    void commit_wait(uint32_t ticket, int64_t timeout_ns = -1){
+        futex_wait(epoch_, ticket, timeout_ns);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_one(){
+        if(has_waiters()){
+            wake(1);
+        }
+    }
+    void notify_all(){
+        if(has_waiters()){
+            wake(INT_MAX);
+        }
+    }
+
+private:
+    bool has_waiters() const{
+        if(asymmetric_){
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        }else{
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return waiters_.load(std::memory_order_relaxed) != 0;
+    }
+    void wake(int count){
+        epoch_.fetch_add(1, std::memory_order_release);
+        futex_wake(epoch_, count);
+    }
+
+    const bool asymmetric_{membarrier_ready()};
+    std::atomic<uint32_t> waiters_{0};
+    std::atomic<uint32_t> epoch_{0};
+};
+
+}
+}
+
+#endif
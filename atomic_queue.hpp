@@ -1,15 +1,23 @@
 #ifndef ATOMIC_QUEUE_HPP
 #define ATOMIC_QUEUE_HPP
 
+#include "atomic_epoch.hpp"
+#include "atomic_park.hpp"
+#include "atomic_status.hpp"
+#include "backoff.hpp"
+#include "wait_strategy.hpp"
+
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <utility>
-#include <vector>
 namespace atomic{
 
-template <typename T>
+// Backoff is applied after every failed CAS on head_, on the tail link, on
+// the shared free list and on the epoch record list.
+template <typename T, typename Backoff = backoff::None>
 class Queue {
 public:
   Queue()
@@ -17,8 +25,11 @@ public:
         tail_(head_.load(std::memory_order_relaxed)) {}
 
   ~Queue() {
+    // Before draining: an exiting thread's release_record() would otherwise
+    // push its cached nodes onto the free list after it was drained.
+    epoch_.shutdown();
     Node* node = head_.load(std::memory_order_relaxed);
-    while (node) {
+    while (node && node != &closed_node_) {
       Node* next = node->next.load(std::memory_order_relaxed);
       delete node;
       node = next;
@@ -31,24 +42,84 @@ public:
   Queue(Queue&&) = delete;
   Queue& operator=(Queue&&) = delete;
 
-  void enqueue(const T& value) {
+  // Returns false, leaving value untouched, once the queue is closed.
+  bool enqueue(const T& value) {
+    if (closed_.load(std::memory_order_relaxed)) {
+      return false;
+    }
     Node* node = make_node(value);
-    enqueue_impl(node);
+    if (enqueue_impl(node)) {
+      return true;
+    }
+    reclaim_node(node);
+    return false;
   }
 
-  void enqueue(T&& value) {
+  bool enqueue(T&& value) {
+    if (closed_.load(std::memory_order_relaxed)) {
+      return false;
+    }
     Node* node = make_node(std::move(value));
-    enqueue_impl(node);
+    if (enqueue_impl(node)) {
+      return true;
+    }
+    value = std::move(*(node->value));
+    reclaim_node(node);
+    return false;
+  }
+
+  // Links [first, last) onto the tail as one pre-built chain, so a burst
+  // costs a single tail CAS instead of one per element. Returns false if
+  // the queue was closed, in which case nothing was enqueued.
+  template <typename InputIt>
+  bool enqueue_bulk(InputIt first, InputIt last) {
+    if (closed_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (first == last) {
+      return true;
+    }
+    EpochGuard guard(epoch_);
+    Node* chain_head = make_node(*first);
+    Node* chain_tail = chain_head;
+    std::size_t count = 1;
+    for (++first; first != last; ++first) {
+      Node* node = make_node(*first);
+      chain_tail->next.store(node, std::memory_order_relaxed);
+      chain_tail = node;
+      ++count;
+    }
+    if (!link_chain(chain_head, chain_tail)) {
+      while (chain_head) {
+        Node* next = chain_head->next.load(std::memory_order_relaxed);
+        reclaim_node(chain_head);
+        chain_head = next;
+      }
+      return false;
+    }
+    guard.record()->enqueued.add(count);
+    parker_.notify_all();
+    return true;
   }
 
   [[nodiscard]] bool try_dequeue(T& out) {
+    return try_dequeue_status(out) == DequeueStatus::ok;
+  }
+
+  // As try_dequeue(), but tells an empty queue apart from a closed and
+  // fully drained one.
+  [[nodiscard]] DequeueStatus try_dequeue_status(T& out) {
     EpochGuard guard(epoch_);
+    Backoff backoff;
     for (;;) {
       Node* head = head_.load(std::memory_order_acquire);
       Node* tail = tail_.load(std::memory_order_acquire);
       Node* next = head->next.load(std::memory_order_acquire);
       if (!next) {
-        return false;
+        return DequeueStatus::empty;
+      }
+      if (next == &closed_node_) {
+        return DequeueStatus::closed;
       }
       if (head == tail) {
         tail_.compare_exchange_weak(
@@ -63,14 +134,175 @@ public:
               std::memory_order_relaxed)) {
         out = std::move(*(next->value));
         epoch_.retire(head);
-        return true;
+        guard.record()->dequeued.add(1);
+        return DequeueStatus::ok;
+      }
+      backoff();
+    }
+  }
+
+  // Dequeues up to max values into out, advancing head_ over all of them
+  // with one CAS. Returns the number of values written.
+  template <typename OutputIt>
+  std::size_t try_dequeue_bulk(OutputIt out, std::size_t max) {
+    std::size_t count = 0;
+    (void)try_dequeue_bulk_status(out, max, count);
+    return count;
+  }
+
+  // As try_dequeue_bulk(), with the number written in count. Returns ok if
+  // count is non-zero (or max is zero), otherwise empty or, once the queue
+  // is closed and drained, closed.
+  template <typename OutputIt>
+  [[nodiscard]] DequeueStatus try_dequeue_bulk_status(OutputIt out, std::size_t max,
+                                                      std::size_t& count) {
+    count = 0;
+    if (max == 0) {
+      return DequeueStatus::ok;
+    }
+    EpochGuard guard(epoch_);
+    Backoff backoff;
+    for (;;) {
+      Node* head = head_.load(std::memory_order_acquire);
+      Node* tail = tail_.load(std::memory_order_acquire);
+      Node* next = head->next.load(std::memory_order_acquire);
+      if (!next) {
+        return DequeueStatus::empty;
+      }
+      if (next == &closed_node_) {
+        return DequeueStatus::closed;
+      }
+      if (head == tail) {
+        tail_.compare_exchange_weak(
+            tail, next,
+            std::memory_order_release,
+            std::memory_order_relaxed);
+        continue;
+      }
+      // Never move head_ past the tail snapshot, so head_ cannot overtake tail_.
+      Node* last = next;
+      count = 1;
+      while (count < max && last != tail) {
+        Node* after = last->next.load(std::memory_order_acquire);
+        if (!after) {
+          break;
+        }
+        last = after;
+        ++count;
+      }
+      if (head_.compare_exchange_weak(
+              head, last,
+              std::memory_order_release,
+              std::memory_order_relaxed)) {
+        Node* node = head;
+        while (node != last) {
+          Node* taken = node->next.load(std::memory_order_relaxed);
+          *out = std::move(*(taken->value));
+          ++out;
+          epoch_.retire(node);
+          node = taken;
+        }
+        guard.record()->dequeued.add(count);
+        return DequeueStatus::ok;
+      }
+      backoff();
+    }
+  }
+
+  // Blocks until a value is dequeued, idling between attempts as Wait
+  // says; the default spins briefly, then parks. Producers only pay for a
+  // wake-up when a consumer is actually parked. Returns false only once the
+  // queue is closed and drained.
+  template <typename Wait = wait::Park>
+  bool dequeue_wait(T& out) {
+    return wait_dequeue<Wait>(out, nullptr) == DequeueStatus::ok;
+  }
+
+  // As dequeue_wait(), but also gives up after timeout. Returns empty if
+  // it timed out and closed once the queue is closed and drained.
+  template <typename Wait = wait::Park, typename Rep, typename Period>
+  [[nodiscard]] DequeueStatus dequeue_for(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+    return wait_dequeue<Wait>(out, &deadline);
+  }
+
+  // Makes further enqueues fail. Values already enqueued can still be
+  // dequeued; after that dequeues report DequeueStatus::closed. Parked
+  // consumers are woken. Returns false if the queue was already closed.
+  bool close() {
+    if (closed_.exchange(true, std::memory_order_acq_rel)) {
+      return false;
+    }
+    {
+      // The sentinel ends the list for good: enqueuers that raced past the
+      // flag either link before it or find it and fail.
+      EpochGuard guard(epoch_);
+      Backoff backoff;
+      for (;;) {
+        Node* tail = tail_.load(std::memory_order_acquire);
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+          if (tail->next.compare_exchange_weak(
+                  next, &closed_node_,
+                  std::memory_order_release,
+                  std::memory_order_relaxed)) {
+            break;
+          }
+          backoff();
+        } else {
+          tail_.compare_exchange_weak(
+              tail, next,
+              std::memory_order_release,
+              std::memory_order_relaxed);
+        }
       }
     }
+    parker_.notify_all();
+    return true;
+  }
+
+  [[nodiscard]] bool is_closed() const {
+    return closed_.load(std::memory_order_acquire);
+  }
+
+  // Approximate number of queued values, summed from per-thread counters so
+  // that tracking it never touches head_/tail_. May lag concurrent calls.
+  [[nodiscard]] std::size_t size() const {
+    std::size_t enqueued = 0;
+    std::size_t dequeued = 0;
+    epoch_.for_each_record([&](const ThreadRecord& record) {
+      dequeued += record.dequeued.get();
+      enqueued += record.enqueued.get();
+    });
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+  // Structural probe: true if no value was linked after the head at the
+  // moment of the check.
+  [[nodiscard]] bool empty() const {
+    EpochGuard guard(epoch_);
+    Node* next = head_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire);
+    return next == nullptr || next == &closed_node_;
+  }
+
+  // Recycled nodes waiting in the shared free list and per-thread caches.
+  [[nodiscard]] std::size_t free_list_depth() const {
+    std::size_t total = free_count_.load(std::memory_order_relaxed);
+    epoch_.for_each_record([&](const ThreadRecord& record) {
+      total += record.local_count.get();
+    });
+    return total;
+  }
+
+  // Dequeued nodes still waiting for their epoch to become safe; a growing
+  // value means some reader is holding reclamation back.
+  [[nodiscard]] std::size_t retired_backlog() const {
+    return epoch_.retired_backlog();
   }
 
 private:
   static constexpr std::size_t kCacheLine = 64;
-  static constexpr std::size_t kRetireThreshold = 64;
   static constexpr std::size_t kLocalCacheLimit = 64;
 
   struct Node {
@@ -81,162 +313,76 @@ private:
     std::atomic<Node*> next{nullptr};
   };
 
-  struct Retired {
-    Node* node;
-    uint64_t epoch;
-  };
-
-  struct alignas(kCacheLine) ThreadRecord {
-    std::atomic<uint64_t> epoch{0};
-    std::atomic<bool> active{false};
-    ThreadRecord* next{nullptr};
-    std::vector<Retired> retired;
-    Node* local_free{nullptr};
-    std::size_t local_count{0};
-  };
-
-  class EpochManager {
-  public:
-    explicit EpochManager(Queue* owner)
-        : owner_(owner) {}
-    ~EpochManager() {
-      ThreadRecord* node = records_.load(std::memory_order_relaxed);
-      while (node) {
-        for (const auto& retired : node->retired) {
-          delete retired.node;
-        }
-        node->retired.clear();
-        owner_->drain_local_cache(node);
-        ThreadRecord* next = node->next;
-        delete node;
-        node = next;
-      }
-    }
-
-    ThreadRecord* get_record() {
-      ThreadRecord* record = find_record();
-      if (record) {
-        return record;
-      }
-      record = new ThreadRecord();
-      ThreadRecord* head = records_.load(std::memory_order_acquire);
-      do {
-        record->next = head;
-      } while (!records_.compare_exchange_weak(
-          head, record,
-          std::memory_order_release,
-          std::memory_order_relaxed));
-      register_record(record);
-      return record;
-    }
+  using Epoch = detail::EpochManager<Queue, Node, Backoff>;
+  using ThreadRecord = typename Epoch::ThreadRecord;
+  using EpochGuard = typename Epoch::Guard;
+  friend Epoch;
 
-    void retire(Node* node) {
-      ThreadRecord* record = get_record();
-      record->retired.push_back(Retired{node, global_epoch_.load(std::memory_order_relaxed)});
-      if (record->retired.size() >= kRetireThreshold) {
-        scan(record);
+  bool enqueue_impl(Node* node) {
+    {
+      EpochGuard guard(epoch_);
+      if (!link_chain(node, node)) {
+        return false;
       }
+      guard.record()->enqueued.add(1);
     }
+    parker_.notify_one();
+    return true;
+  }
 
-    class Guard {
-    public:
-      explicit Guard(EpochManager& manager)
-          : manager_(manager),
-            record_(manager_.get_record()) {
-        record_->epoch.store(manager_.global_epoch_.load(std::memory_order_acquire),
-                             std::memory_order_release);
-        record_->active.store(true, std::memory_order_release);
-      }
-
-      ~Guard() {
-        record_->active.store(false, std::memory_order_release);
-      }
-
-    private:
-      EpochManager& manager_;
-      ThreadRecord* record_;
+  template <typename Wait>
+  DequeueStatus wait_dequeue(T& out, const std::chrono::steady_clock::time_point* deadline) {
+    Wait wait;
+    DequeueStatus status = DequeueStatus::empty;
+    // Retrying the dequeue is itself the probe: link_chain publishes before
+    // notifying, and the Parker handshake keeps a parked consumer from
+    // missing it.
+    auto probe = [&]() {
+      status = try_dequeue_status(out);
+      return status != DequeueStatus::empty;
     };
-
-  private:
-    void scan(ThreadRecord* record) {
-      advance_epoch();
-      const uint64_t cur = global_epoch_.load(std::memory_order_acquire);
-      const uint64_t safe_epoch = (cur >= 2) ? cur - 2 : 0;
-
-      std::vector<Retired> remaining;
-      remaining.reserve(record->retired.size());
-      for (const auto& r : record->retired) {
-        if (r.epoch <= safe_epoch) {
-          owner_->reclaim_node(r.node);
-        } else {
-          remaining.push_back(r);
-        }
+    for (;;) {
+      if (probe()) {
+        return status;
       }
-      record->retired.swap(remaining);
-    }
-
-    void advance_epoch() {
-      const uint64_t cur = global_epoch_.load(std::memory_order_acquire);
-      ThreadRecord* node = records_.load(std::memory_order_acquire);
-      while (node) {
-        if (node->active.load(std::memory_order_acquire) &&
-            node->epoch.load(std::memory_order_acquire) != cur) {
-          return;
+      int64_t timeout_ns = -1;
+      if (deadline) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= *deadline) {
+          return DequeueStatus::empty;
         }
-        node = node->next;
+        timeout_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - now).count();
       }
-      uint64_t expected = cur;
-      global_epoch_.compare_exchange_weak(
-          expected, cur + 1,
-          std::memory_order_release,
-          std::memory_order_relaxed);
-    }
-
-    ThreadRecord* find_record() {
-      auto& slots = tls_records();
-      for (auto& slot : slots) {
-        if (slot.manager == this) {
-          return slot.record;
-        }
+      wait.idle(parker_, probe, timeout_ns);
+      if (status != DequeueStatus::empty) {
+        return status;
       }
-      return nullptr;
     }
+  }
 
-    void register_record(ThreadRecord* record) {
-      tls_records().push_back(Slot{this, record});
-    }
-
-    struct Slot {
-      EpochManager* manager;
-      ThreadRecord* record;
-    };
-
-    static std::vector<Slot>& tls_records() {
-      thread_local std::vector<Slot> records;
-      return records;
-    }
-
-    alignas(kCacheLine) std::atomic<uint64_t> global_epoch_{0};
-    std::atomic<ThreadRecord*> records_{nullptr};
-    Queue* owner_{nullptr};
-  };
-
-  void enqueue_impl(Node* node) {
-    EpochGuard guard(epoch_);
+  // Caller must hold an EpochGuard. The chain first..last must already be
+  // linked through next and end with a null next. Returns false if the
+  // closed sentinel is already linked.
+  bool link_chain(Node* first, Node* last) {
+    Backoff backoff;
     for (;;) {
       Node* tail = tail_.load(std::memory_order_acquire);
       Node* next = tail->next.load(std::memory_order_acquire);
+      if (next == &closed_node_) {
+        return false;
+      }
       if (!next) {
         if (tail->next.compare_exchange_weak(
-                next, node,
+                next, first,
                 std::memory_order_release,
                 std::memory_order_relaxed)) {
           tail_.compare_exchange_weak(
-              tail, node,
+              tail, last,
               std::memory_order_release,
               std::memory_order_relaxed);
-          return;
+          return true;
         }
+        backoff();
       } else {
         tail_.compare_exchange_weak(
             tail, next,
@@ -246,8 +392,6 @@ private:
     }
   }
 
-  using EpochGuard = typename EpochManager::Guard;
-
   Node* make_node(const T& value) {
     Node* node = acquire_node();
     node->value.emplace(value);
@@ -265,7 +409,7 @@ private:
     if (record->local_free) {
       Node* node = record->local_free;
       record->local_free = node->next.load(std::memory_order_relaxed);
-      record->local_count--;
+      record->local_count.sub(1);
       node->next.store(nullptr, std::memory_order_relaxed);
       return node;
     }
@@ -282,19 +426,28 @@ private:
     ThreadRecord* record = epoch_.get_record();
     node->next.store(record->local_free, std::memory_order_relaxed);
     record->local_free = node;
-    record->local_count++;
-    if (record->local_count >= kLocalCacheLimit) {
+    record->local_count.add(1);
+    if (record->local_count.get() >= kLocalCacheLimit) {
       flush_local_cache(record);
     }
   }
 
   void flush_local_cache(ThreadRecord* record) {
-    while (record->local_free && record->local_count > kLocalCacheLimit / 2) {
+    while (record->local_free && record->local_count.get() > kLocalCacheLimit / 2) {
+      Node* node = record->local_free;
+      record->local_free = node->next.load(std::memory_order_relaxed);
+      record->local_count.sub(1);
+      push_global(node);
+    }
+  }
+
+  void orphan_local_cache(ThreadRecord* record) {
+    while (record->local_free) {
       Node* node = record->local_free;
       record->local_free = node->next.load(std::memory_order_relaxed);
-      record->local_count--;
       push_global(node);
     }
+    record->local_count.set(0);
   }
 
   void drain_local_cache(ThreadRecord* record) {
@@ -305,10 +458,11 @@ private:
       node = next;
     }
     record->local_free = nullptr;
-    record->local_count = 0;
+    record->local_count.set(0);
   }
 
   Node* pop_global() {
+    Backoff backoff;
     Node* head = free_head_.load(std::memory_order_acquire);
     while (head) {
       Node* next = head->next.load(std::memory_order_relaxed);
@@ -316,20 +470,27 @@ private:
               head, next,
               std::memory_order_acquire,
               std::memory_order_relaxed)) {
+        free_count_.fetch_sub(1, std::memory_order_relaxed);
         return head;
       }
+      backoff();
     }
     return nullptr;
   }
 
   void push_global(Node* node) {
+    // Counted before publishing so a racing pop_global() cannot underflow it.
+    free_count_.fetch_add(1, std::memory_order_relaxed);
+    Backoff backoff;
     Node* head = free_head_.load(std::memory_order_relaxed);
-    do {
-      node->next.store(head, std::memory_order_relaxed);
-    } while (!free_head_.compare_exchange_weak(
+    node->next.store(head, std::memory_order_relaxed);
+    while (!free_head_.compare_exchange_weak(
         head, node,
         std::memory_order_release,
-        std::memory_order_relaxed));
+        std::memory_order_relaxed)) {
+      node->next.store(head, std::memory_order_relaxed);
+      backoff();
+    }
   }
 
   void drain_free_list() {
@@ -341,10 +502,15 @@ private:
     }
   }
 
-  EpochManager epoch_{this};
+  // mutable: const observers such as empty() still need to pin an epoch.
+  mutable Epoch epoch_{this};
   alignas(kCacheLine) std::atomic<Node*> head_;
   alignas(kCacheLine) std::atomic<Node*> tail_;
   alignas(kCacheLine) std::atomic<Node*> free_head_{nullptr};
+  std::atomic<std::size_t> free_count_{0};
+  alignas(kCacheLine) std::atomic<bool> closed_{false};
+  Node closed_node_;
+  detail::Parker parker_;
 };
 }
 
@@ -1,24 +1,170 @@
 #ifndef ATOMIC_RING_HPP
 #define ATOMIC_RING_HPP
+#include "atomic_park.hpp"
+#include "atomic_status.hpp"
+#include "backoff.hpp"
+#include "wait_strategy.hpp"
+
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 namespace atomic{
+
+// Page backing for heap-allocated rings.
+enum class HugePages{
+    none,
+    transparent,   // normal mapping plus MADV_HUGEPAGE
+    explicit_tlb,  // MAP_HUGETLB, falling back to transparent if none are reserved
+};
+
+namespace detail{
+
+// Zero-filled memory straight from the OS. Pages are faulted in only when
+// first written, so they land on the NUMA node of the first thread that
+// uses them and construction costs nothing up front.
+class ZeroedPages{
+public:
+    ZeroedPages(std::size_t bytes, HugePages huge) : bytes_(bytes){
+#ifdef __linux__
+        constexpr std::size_t kHugePage = std::size_t{2} << 20;
+        if(huge == HugePages::explicit_tlb && bytes <= SIZE_MAX - (kHugePage - 1)){
+            const std::size_t rounded = (bytes + kHugePage - 1) & ~(kHugePage - 1);
+            void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(p != MAP_FAILED){
+                data_ = p;
+                bytes_ = rounded;
+                return;
+            }
+            huge = HugePages::transparent;
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED){
+            throw std::bad_alloc();
+        }
+        if(huge == HugePages::transparent){
+            madvise(p, bytes, MADV_HUGEPAGE);
+        }
+        data_ = p;
+#else
+        (void)huge;
+        data_ = std::calloc(1, bytes);
+        if(!data_){
+            throw std::bad_alloc();
+        }
+#endif
+    }
+    ~ZeroedPages(){
+#ifdef __linux__
+        munmap(data_, bytes_);
+#else
+        std::free(data_);
+#endif
+    }
+    ZeroedPages(const ZeroedPages&)=delete;
+    ZeroedPages& operator=(const ZeroedPages&)=delete;
+
+    void* data() const{
+        return data_;
+    }
+
+private:
+    void* data_{nullptr};
+    std::size_t bytes_;
+};
+
+}
+
 namespace MPMC{
 
-template <typename EleType, std::size_t Cap>
+// Slot layout policies for RingBuffer. Neighbouring positions are usually
+// served by different threads at the same moment, so with small elements
+// Packed has them fighting over one cache line.
+namespace layout{
+
+// Slots back to back: smallest footprint, most false sharing.
+struct Packed{
+    template <std::size_t NaturalSize>
+    static constexpr std::size_t kSlotAlign = 0;
+    template <std::size_t Cap, std::size_t SlotSize>
+    static constexpr std::size_t index(std::size_t pos){
+        return pos;
+    }
+};
+
+// Every slot on its own cache line.
+struct Padded{
+    template <std::size_t NaturalSize>
+    static constexpr std::size_t kSlotAlign = 64;
+    template <std::size_t Cap, std::size_t SlotSize>
+    static constexpr std::size_t index(std::size_t pos){
+        return pos;
+    }
+};
+
+// Slots are padded to a power-of-two size (at most a line) so none
+// straddles a line, then consecutive positions are dealt round-robin
+// across cache lines, so position i and i+1 only share a line again
+// Cap/per_line positions later.
+struct Remapped{
+private:
+    static constexpr std::size_t ceil_pow2(std::size_t n){
+        std::size_t p = 1;
+        while(p < n){
+            p *= 2;
+        }
+        return p;
+    }
+
+public:
+    template <std::size_t NaturalSize>
+    static constexpr std::size_t kSlotAlign = ceil_pow2(NaturalSize < 64 ? NaturalSize : 64);
+    template <std::size_t Cap, std::size_t SlotSize>
+    static constexpr std::size_t index(std::size_t pos){
+        static_assert(SlotSize >= 64 || 64 % SlotSize == 0, "Remapped slots must tile a cache line.");
+        constexpr std::size_t per_line = SlotSize >= 64 ? 1 : 64 / SlotSize;
+        if constexpr(per_line == 1 || Cap <= per_line){
+            return pos;
+        }else{
+            constexpr std::size_t lines = Cap / per_line;
+            return (pos % lines) * per_line + pos / lines;
+        }
+    }
+};
+
+}
+
+// Backoff is applied after every lost CAS on head_ or tail_.
+template <typename EleType, std::size_t Cap, typename Layout = layout::Packed,
+    typename Backoff = backoff::None>
 class RingBuffer{
 private:
     struct Slot;
     static constexpr std::size_t kMask = Cap - 1;
-    
+    // Set in tail_ by close(); positions never get anywhere near it.
+    static constexpr std::size_t kClosedBit =
+        std::size_t{1} << (std::numeric_limits<std::size_t>::digits - 1);
+
 public:
     static_assert((Cap & (Cap - 1)) == 0, "Cap must be power of two.");
     RingBuffer() : head_(0), tail_(0) {
         for(std::size_t i = 0; i < Cap; ++i){
-            slots_[i].seq.store(i, std::memory_order_relaxed);
+            slot_at(i).seq.store(i, std::memory_order_relaxed);
         }
     }
     ~RingBuffer()=default;
@@ -34,9 +180,354 @@ public:
         return enqueue_impl(std::move(ele));
     }
     bool enqueue_impl(EleType ele){
+        std::size_t pos;
+        Slot* slot = claim_write(pos);
+        if(!slot){
+            return false;
+        }
+        slot->ele_ = std::move(ele);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        not_empty_.notify_one();
+        return true;
+    }
+    bool try_dequeue(EleType& out){
+        return try_dequeue_status(out) == DequeueStatus::ok;
+    }
+    // As try_dequeue(), but tells an empty ring apart from a closed and
+    // fully drained one.
+    DequeueStatus try_dequeue_status(EleType& out){
+        std::size_t pos;
+        Slot* slot;
+        const DequeueStatus status = claim_read(pos, slot);
+        if(status == DequeueStatus::ok){
+            out = std::move(slot->ele_);
+            slot->seq.store(pos + Cap, std::memory_order_release);
+            not_full_.notify_one();
+        }
+        return status;
+    }
+
+    // Blocking forms of try_enqueue()/try_dequeue_status(), idling between
+    // attempts as Wait says. enqueue() returns false only once the ring is
+    // closed; dequeue() only once it is closed and drained.
+    template <typename Wait = wait::Park>
+    bool enqueue(const EleType& ele){
+        return wait_enqueue<Wait>(ele);
+    }
+    template <typename Wait = wait::Park>
+    bool enqueue(EleType&& ele){
+        return wait_enqueue<Wait>(std::move(ele));
+    }
+    template <typename Wait = wait::Park>
+    bool dequeue(EleType& out){
+        return wait_dequeue<Wait>(out, nullptr) == DequeueStatus::ok;
+    }
+    // As dequeue(), but also gives up after timeout. Returns empty if it
+    // timed out and closed once the ring is closed and drained.
+    template <typename Wait = wait::Park, typename Rep, typename Period>
+    DequeueStatus dequeue_for(EleType& out, const std::chrono::duration<Rep, Period>& timeout){
+        const auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+        return wait_dequeue<Wait>(out, &deadline);
+    }
+
+    // Enqueues up to n elements from first with a single CAS on tail_ and
+    // returns how many; fewer than n when the ring has less contiguous room.
+    template <typename InputIt>
+    std::size_t try_enqueue_bulk(InputIt first, std::size_t n){
+        if(n == 0){
+            return 0;
+        }
         std::size_t pos = tail_.load(std::memory_order_relaxed);
+        std::size_t count;
+        Backoff backoff;
         for(;;){
-            Slot& slot = slots_[pos & kMask];
+            if(pos & kClosedBit){
+                return 0;
+            }
+            count = 0;
+            while(count < n && slot_at(pos + count).seq.load(std::memory_order_acquire) == pos + count){
+                ++count;
+            }
+            if(count == 0){
+                const std::size_t seq = slot_at(pos).seq.load(std::memory_order_acquire);
+                if(static_cast<std::ptrdiff_t>(seq - pos) < 0){
+                    return 0;
+                }
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if(tail_.compare_exchange_weak(
+                    pos, pos + count,
+                    std::memory_order_relaxed,
+                    std::memory_order_relaxed)){
+                break;
+            }
+            backoff();
+        }
+        for(std::size_t i = 0; i < count; ++i, ++first){
+            Slot& slot = slot_at(pos + i);
+            slot.ele_ = *first;
+            slot.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        not_empty_.notify_all();
+        return count;
+    }
+    // Dequeues up to max elements into out with a single CAS on head_ and
+    // returns how many.
+    template <typename OutputIt>
+    std::size_t try_dequeue_bulk(OutputIt out, std::size_t max){
+        std::size_t count = 0;
+        (void)try_dequeue_bulk_status(out, max, count);
+        return count;
+    }
+    // As try_dequeue_bulk(), with the number written in count. Returns ok if
+    // count is non-zero (or max is zero), otherwise empty or, once the ring
+    // is closed and drained, closed.
+    template <typename OutputIt>
+    DequeueStatus try_dequeue_bulk_status(OutputIt out, std::size_t max, std::size_t& count){
+        count = 0;
+        if(max == 0){
+            return DequeueStatus::ok;
+        }
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            count = 0;
+            while(count < max && slot_at(pos + count).seq.load(std::memory_order_acquire) == pos + count + 1){
+                ++count;
+            }
+            if(count == 0){
+                const std::size_t seq = slot_at(pos).seq.load(std::memory_order_acquire);
+                if(static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0){
+                    return empty_or_closed(pos);
+                }
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if(head_.compare_exchange_weak(
+                    pos, pos + count,
+                    std::memory_order_relaxed,
+                    std::memory_order_relaxed)){
+                break;
+            }
+            backoff();
+        }
+        for(std::size_t i = 0; i < count; ++i, ++out){
+            Slot& slot = slot_at(pos + i);
+            *out = std::move(slot.ele_);
+            slot.seq.store(pos + i + Cap, std::memory_order_release);
+        }
+        not_full_.notify_all();
+        return DequeueStatus::ok;
+    }
+
+    // Claimed slot for writing in place. The element is published to
+    // consumers by commit(), or by the destructor if commit() was not
+    // called, since a claimed slot must always be handed on.
+    class WriteHandle{
+    public:
+        WriteHandle()=default;
+        WriteHandle(WriteHandle&& other) noexcept
+            : ring_(other.ring_), slot_(std::exchange(other.slot_, nullptr)), pos_(other.pos_) {}
+        WriteHandle& operator=(WriteHandle&& other) noexcept{
+            if(this != &other){
+                commit();
+                ring_ = other.ring_;
+                slot_ = std::exchange(other.slot_, nullptr);
+                pos_ = other.pos_;
+            }
+            return *this;
+        }
+        ~WriteHandle(){
+            commit();
+        }
+
+        explicit operator bool() const{
+            return slot_ != nullptr;
+        }
+        EleType& operator*() const{
+            return slot_->ele_;
+        }
+        EleType* operator->() const{
+            return &slot_->ele_;
+        }
+        void commit(){
+            if(slot_){
+                slot_->seq.store(pos_ + 1, std::memory_order_release);
+                slot_ = nullptr;
+                ring_->not_empty_.notify_one();
+            }
+        }
+
+    private:
+        friend class RingBuffer;
+        WriteHandle(RingBuffer* ring, Slot* slot, std::size_t pos)
+            : ring_(ring), slot_(slot), pos_(pos) {}
+        RingBuffer* ring_{nullptr};
+        Slot* slot_{nullptr};
+        std::size_t pos_{0};
+    };
+
+    // Claimed slot for reading in place. The slot goes back to producers on
+    // release() or destruction; the element is left as is, not destroyed.
+    class ReadHandle{
+    public:
+        ReadHandle()=default;
+        ReadHandle(ReadHandle&& other) noexcept
+            : ring_(other.ring_), slot_(std::exchange(other.slot_, nullptr)), pos_(other.pos_) {}
+        ReadHandle& operator=(ReadHandle&& other) noexcept{
+            if(this != &other){
+                release();
+                ring_ = other.ring_;
+                slot_ = std::exchange(other.slot_, nullptr);
+                pos_ = other.pos_;
+            }
+            return *this;
+        }
+        ~ReadHandle(){
+            release();
+        }
+
+        explicit operator bool() const{
+            return slot_ != nullptr;
+        }
+        EleType& operator*() const{
+            return slot_->ele_;
+        }
+        EleType* operator->() const{
+            return &slot_->ele_;
+        }
+        void release(){
+            if(slot_){
+                slot_->seq.store(pos_ + Cap, std::memory_order_release);
+                slot_ = nullptr;
+                ring_->not_full_.notify_one();
+            }
+        }
+
+    private:
+        friend class RingBuffer;
+        ReadHandle(RingBuffer* ring, Slot* slot, std::size_t pos)
+            : ring_(ring), slot_(slot), pos_(pos) {}
+        RingBuffer* ring_{nullptr};
+        Slot* slot_{nullptr};
+        std::size_t pos_{0};
+    };
+
+    // Zero-copy variants of try_enqueue()/try_dequeue(). An empty handle
+    // means full (or closed) and empty respectively. Holding a handle
+    // stalls the ring at that position, so keep it short-lived.
+    WriteHandle try_claim(){
+        std::size_t pos;
+        Slot* slot = claim_write(pos);
+        return slot ? WriteHandle(this, slot, pos) : WriteHandle();
+    }
+    ReadHandle try_peek(){
+        std::size_t pos;
+        Slot* slot;
+        if(claim_read(pos, slot) != DequeueStatus::ok){
+            return ReadHandle();
+        }
+        return ReadHandle(this, slot, pos);
+    }
+
+    // Makes further enqueues fail; consumers drain what is left and then
+    // get DequeueStatus::closed. Returns false if already closed.
+    bool close(){
+        if(tail_.fetch_or(kClosedBit, std::memory_order_acq_rel) & kClosedBit){
+            return false;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+        return true;
+    }
+    bool is_closed() const{
+        return (tail_.load(std::memory_order_acquire) & kClosedBit) != 0;
+    }
+
+
+
+private:
+    struct NaturalSlot{
+        std::atomic<std::size_t> seq;
+        EleType ele_;
+    };
+    static constexpr std::size_t kLayoutAlign = Layout::template kSlotAlign<sizeof(NaturalSlot)>;
+    static constexpr std::size_t kSeqAlign =
+        kLayoutAlign > alignof(NaturalSlot) ? kLayoutAlign : alignof(NaturalSlot);
+    struct Slot{
+        alignas(kSeqAlign) std::atomic<std::size_t> seq{0};
+        EleType ele_;
+    };
+    Slot& slot_at(std::size_t pos){
+        return slots_[Layout::template index<Cap, sizeof(Slot)>(pos & kMask)];
+    }
+    template <typename Wait>
+    DequeueStatus wait_dequeue(EleType& out, const std::chrono::steady_clock::time_point* deadline){
+        Wait wait;
+        for(;;){
+            std::size_t pos;
+            Slot* slot;
+            const DequeueStatus status = claim_read(pos, slot);
+            if(status == DequeueStatus::ok){
+                out = std::move(slot->ele_);
+                slot->seq.store(pos + Cap, std::memory_order_release);
+                not_full_.notify_one();
+                return status;
+            }
+            if(status == DequeueStatus::closed){
+                return status;
+            }
+            int64_t timeout_ns = -1;
+            if(deadline){
+                const auto now = std::chrono::steady_clock::now();
+                if(now >= *deadline){
+                    return DequeueStatus::empty;
+                }
+                timeout_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - now).count();
+            }
+            // The producer of pos claims it through tail_ before notifying,
+            // so the Parker handshake lets either the probe see the claim or
+            // the producer see this consumer parked. A claimed but
+            // unpublished slot is waited out without parking.
+            wait.idle(not_empty_, [&]{
+                const std::size_t tail = tail_.load(std::memory_order_relaxed);
+                return (tail & kClosedBit) != 0 || tail != pos;
+            }, timeout_ns);
+        }
+    }
+    template <typename Wait, typename U>
+    bool wait_enqueue(U&& ele){
+        Wait wait;
+        for(;;){
+            std::size_t pos;
+            if(Slot* slot = claim_write(pos)){
+                slot->ele_ = std::forward<U>(ele);
+                slot->seq.store(pos + 1, std::memory_order_release);
+                not_empty_.notify_one();
+                return true;
+            }
+            if(is_closed()){
+                return false;
+            }
+            // Same handshake as dequeue(): pos frees up once the consumer of
+            // pos - Cap has claimed it through head_.
+            wait.idle(not_full_, [&]{
+                return is_closed() || head_.load(std::memory_order_relaxed) + Cap > pos;
+            });
+        }
+    }
+
+    // Claims the next write position; nullptr if full or closed.
+    Slot* claim_write(std::size_t& pos){
+        pos = tail_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            if(pos & kClosedBit){
+                return nullptr;
+            }
+            Slot& slot = slot_at(pos);
             std::size_t seq = slot.seq.load(std::memory_order_acquire);
             std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) -
                 static_cast<std::ptrdiff_t>(pos);
@@ -45,21 +536,21 @@ public:
                         pos, pos + 1,
                         std::memory_order_relaxed,
                         std::memory_order_relaxed)){
-                    slot.ele_ = std::move(ele);
-                    slot.seq.store(pos + 1, std::memory_order_release);
-                    return true;
+                    return &slot;
                 }
+                backoff();
             }else if(diff < 0){
-                return false;
+                return nullptr;
             }else{
                 pos = tail_.load(std::memory_order_relaxed);
             }
         }
     }
-    bool try_dequeue(EleType& out){
-        std::size_t pos = head_.load(std::memory_order_relaxed);
+    DequeueStatus claim_read(std::size_t& pos, Slot*& out){
+        pos = head_.load(std::memory_order_relaxed);
+        Backoff backoff;
         for(;;){
-            Slot& slot = slots_[pos & kMask];
+            Slot& slot = slot_at(pos);
             std::size_t seq = slot.seq.load(std::memory_order_acquire);
             std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) -
                 static_cast<std::ptrdiff_t>(pos + 1);
@@ -68,31 +559,573 @@ public:
                         pos, pos + 1,
                         std::memory_order_relaxed,
                         std::memory_order_relaxed)){
-                    out = std::move(slot.ele_);
-                    slot.seq.store(pos + Cap, std::memory_order_release);
+                    out = &slot;
+                    return DequeueStatus::ok;
+                }
+                backoff();
+            }else if(diff < 0){
+                return empty_or_closed(pos);
+            }else{
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    // Nothing is published at pos; closed only if no producer claimed pos
+    // before close().
+    DequeueStatus empty_or_closed(std::size_t pos) const{
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        if((tail & kClosedBit) && (tail & ~kClosedBit) == pos){
+            return DequeueStatus::closed;
+        }
+        return DequeueStatus::empty;
+    }
+    alignas(64) std::atomic<std::size_t> head_;
+    alignas(64) std::atomic<std::size_t> tail_;
+    // Parked consumers and producers of the blocking calls.
+    detail::Parker not_empty_;
+    detail::Parker not_full_;
+    // Line-aligned so the layouts' slot boundaries match line boundaries.
+    alignas(64) std::array<Slot, Cap> slots_;
+};
+
+// RingBuffer with a capacity chosen at run time (rounded up to a power of
+// two) and slots in OS-provided zeroed pages. Each slot stores its sequence
+// relative to its index, so all-zero memory already is an empty ring: there
+// is no initialisation pass, and huge rings only fault in the pages they
+// actually use. Elements are constructed on enqueue and destroyed on
+// dequeue, so EleType need not be default-constructible. A capacity of zero,
+// or one whose slot array would not fit in size_t bytes, throws
+// std::length_error; failing to map the pages throws std::bad_alloc.
+template <typename EleType, typename Backoff = backoff::None>
+class DynamicRingBuffer{
+private:
+    static constexpr std::size_t kClosedBit =
+        std::size_t{1} << (std::numeric_limits<std::size_t>::digits - 1);
+
+public:
+    explicit DynamicRingBuffer(std::size_t capacity, HugePages huge = HugePages::none)
+        : cap_(checked_capacity(capacity)),
+          mask_(cap_ - 1),
+          pages_(cap_ * sizeof(Slot), huge),
+          slots_(static_cast<Slot*>(pages_.data())),
+          head_(0),
+          tail_(0) {}
+    ~DynamicRingBuffer(){
+        const std::size_t tail = tail_.load(std::memory_order_relaxed) & ~kClosedBit;
+        for(std::size_t pos = head_.load(std::memory_order_relaxed); pos != tail; ++pos){
+            if(seq_of(pos) == pos + 1){
+                slots_[pos & mask_].ptr()->~EleType();
+            }
+        }
+    }
+    DynamicRingBuffer(const DynamicRingBuffer&)=delete;
+    DynamicRingBuffer& operator=(const DynamicRingBuffer&)=delete;
+    DynamicRingBuffer(DynamicRingBuffer&&)=delete;
+    DynamicRingBuffer& operator=(DynamicRingBuffer&&)=delete;
+
+    std::size_t capacity() const{
+        return cap_;
+    }
+
+    bool try_enqueue(const EleType& ele){
+        return enqueue_impl(ele);
+    }
+    bool try_enqueue(EleType&& ele){
+        return enqueue_impl(std::move(ele));
+    }
+    bool try_dequeue(EleType& out){
+        return try_dequeue_status(out) == DequeueStatus::ok;
+    }
+    DequeueStatus try_dequeue_status(EleType& out){
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq_of(pos)) -
+                static_cast<std::ptrdiff_t>(pos + 1);
+            if(diff == 0){
+                if(head_.compare_exchange_weak(
+                        pos, pos + 1,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    Slot& slot = slots_[pos & mask_];
+                    EleType* ele = slot.ptr();
+                    out = std::move(*ele);
+                    ele->~EleType();
+                    publish(slot, pos, pos + cap_);
+                    return DequeueStatus::ok;
+                }
+                backoff();
+            }else if(diff < 0){
+                const std::size_t tail = tail_.load(std::memory_order_acquire);
+                if((tail & kClosedBit) && (tail & ~kClosedBit) == pos){
+                    return DequeueStatus::closed;
+                }
+                return DequeueStatus::empty;
+            }else{
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool close(){
+        return (tail_.fetch_or(kClosedBit, std::memory_order_acq_rel) & kClosedBit) == 0;
+    }
+    bool is_closed() const{
+        return (tail_.load(std::memory_order_acquire) & kClosedBit) != 0;
+    }
+
+private:
+    struct Slot{
+        std::atomic<std::size_t> seq;
+        alignas(EleType) unsigned char storage[sizeof(EleType)];
+        EleType* ptr(){ return std::launder(reinterpret_cast<EleType*>(storage)); }
+    };
+
+    // Largest power of two whose slot array still fits in size_t bytes.
+    static constexpr std::size_t kMaxCapacity = [](){
+        std::size_t cap = 1;
+        while(cap <= SIZE_MAX / sizeof(Slot) / 2){
+            cap <<= 1;
+        }
+        return cap;
+    }();
+
+    static std::size_t checked_capacity(std::size_t n){
+        if(n == 0){
+            throw std::length_error("DynamicRingBuffer: capacity must be positive");
+        }
+        if(n > kMaxCapacity){
+            throw std::length_error("DynamicRingBuffer: capacity too large");
+        }
+        std::size_t cap = 1;
+        while(cap < n){
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    // Stored value is seq - index, which starts at zero for every slot.
+    std::size_t seq_of(std::size_t pos) const{
+        return slots_[pos & mask_].seq.load(std::memory_order_acquire) + (pos & mask_);
+    }
+    void publish(Slot& slot, std::size_t pos, std::size_t seq){
+        slot.seq.store(seq - (pos & mask_), std::memory_order_release);
+    }
+
+    template <typename U>
+    bool enqueue_impl(U&& ele){
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            if(pos & kClosedBit){
+                return false;
+            }
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq_of(pos)) -
+                static_cast<std::ptrdiff_t>(pos);
+            if(diff == 0){
+                if(tail_.compare_exchange_weak(
+                        pos, pos + 1,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    Slot& slot = slots_[pos & mask_];
+                    ::new (static_cast<void*>(slot.storage)) EleType(std::forward<U>(ele));
+                    publish(slot, pos, pos + 1);
                     return true;
                 }
+                backoff();
             }else if(diff < 0){
                 return false;
             }else{
-                pos = head_.load(std::memory_order_relaxed);
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    const std::size_t cap_;
+    const std::size_t mask_;
+    detail::ZeroedPages pages_;
+    Slot* slots_;
+    alignas(64) std::atomic<std::size_t> head_;
+    alignas(64) std::atomic<std::size_t> tail_;
+};
+
+// Ring that overwrites the oldest entry instead of failing when full. A
+// producer claims a position with fetch_add and writes it as a seqlock, so
+// it never waits on consumers or other producers. Consumers validate the
+// slot sequence before and after copying out and skip whatever was
+// overwritten, counting it in dropped(). The payload is stored as atomic
+// words, hence the trivially copyable requirement. Backoff only paces the
+// slot and head_ CAS retries; a producer never waits for a consumer.
+template <typename EleType, std::size_t Cap, typename Backoff = backoff::None>
+class LossyRingBuffer{
+private:
+    static constexpr std::size_t kMask = Cap - 1;
+    static constexpr std::size_t kWords = (sizeof(EleType) + 7) / 8;
+
+public:
+    static_assert((Cap & (Cap - 1)) == 0, "Cap must be power of two.");
+    static_assert(std::is_trivially_copyable<EleType>::value,
+        "LossyRingBuffer needs a trivially copyable EleType.");
+    LossyRingBuffer()=default;
+    ~LossyRingBuffer()=default;
+    LossyRingBuffer(const LossyRingBuffer&)=delete;
+    LossyRingBuffer& operator=(const LossyRingBuffer&)=delete;
+    LossyRingBuffer(LossyRingBuffer&&)=delete;
+    LossyRingBuffer& operator=(LossyRingBuffer&&)=delete;
+
+    void enqueue(const EleType& ele){
+        const uint64_t pos = tail_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[pos & kMask];
+        uint64_t cur = slot.seq.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            if(cur >= writing(pos)){
+                // A producer from a later lap already owns the slot.
+                return;
+            }
+            if(cur & 1){
+                // A producer from an earlier lap is still writing; give up
+                // this entry rather than wait, and tell consumers to skip it.
+                mark_skipped(slot, pos);
+                return;
+            }
+            if(slot.seq.compare_exchange_weak(
+                    cur, writing(pos),
+                    std::memory_order_relaxed,
+                    std::memory_order_relaxed)){
+                break;
+            }
+            backoff();
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &ele, sizeof(EleType));
+        for(std::size_t i = 0; i < kWords; ++i){
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(written(pos), std::memory_order_release);
+    }
+    // Always succeeds; present so the ring can stand in for the others.
+    bool try_enqueue(const EleType& ele){
+        enqueue(ele);
+        return true;
+    }
+
+    bool try_dequeue(EleType& out){
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            Slot& slot = slots_[pos & kMask];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if(seq == written(pos)){
+                uint64_t words[kWords];
+                for(std::size_t i = 0; i < kWords; ++i){
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(slot.seq.load(std::memory_order_relaxed) != seq){
+                    continue;  // overwritten mid-copy; take the skip path
+                }
+                if(head_.compare_exchange_weak(
+                        pos, pos + 1,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    std::memcpy(&out, words, sizeof(EleType));
+                    return true;
+                }
+                backoff();
+            }else if(seq > written(pos)){
+                // Lapped: everything before tail - Cap has been overwritten.
+                const uint64_t tail = tail_.load(std::memory_order_relaxed);
+                const uint64_t target = tail - pos > Cap ? tail - Cap : pos + 1;
+                if(head_.compare_exchange_weak(
+                        pos, target,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    dropped_.fetch_add(target - pos, std::memory_order_relaxed);
+                    pos = target;
+                }else{
+                    backoff();
+                }
+            }else if(seq != writing(pos) &&
+                    slot.skipped.load(std::memory_order_acquire) > pos){
+                if(head_.compare_exchange_weak(
+                        pos, pos + 1,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    ++pos;
+                }else{
+                    backoff();
+                }
+            }else{
+                return false;
             }
         }
     }
 
+    // Entries overwritten or abandoned before any consumer read them.
+    uint64_t dropped() const{
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot{
+        // 0 before the first write, then 2 * pos + 1 while pos is being
+        // written and 2 * pos + 2 once it is complete.
+        std::atomic<uint64_t> seq{0};
+        // One past the highest position abandoned on this slot.
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> words[kWords]{};
+    };
+
+    static constexpr uint64_t writing(uint64_t pos){
+        return 2 * pos + 1;
+    }
+    static constexpr uint64_t written(uint64_t pos){
+        return 2 * pos + 2;
+    }
+    static void mark_skipped(Slot& slot, uint64_t pos){
+        uint64_t cur = slot.skipped.load(std::memory_order_relaxed);
+        Backoff backoff;
+        while(cur < pos + 1 && !slot.skipped.compare_exchange_weak(
+                cur, pos + 1,
+                std::memory_order_release,
+                std::memory_order_relaxed)){
+            backoff();
+        }
+    }
+
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    std::array<Slot, Cap> slots_;
+};
+
+
+}
+
+namespace MPSC{
+
+// What a producer does when the ring is full.
+enum class FullPolicy{
+    // Fail fast: never waits on the consumer. Producers first reserve room
+    // with a fetch_add on a separate counter and undo it when the ring is
+    // full, so a slot is only claimed once it is known to be free.
+    reject,
+    // Always claim, then spin until the consumer frees the slot.
+    block,
+};
+
+// Multi-producer single-consumer ring. Producers claim positions with one
+// fetch_add instead of a CAS loop, so they never retry against each other;
+// the consumer owns head_ outright and reads without any read-modify-write.
+template <typename EleType, std::size_t Cap, FullPolicy Policy = FullPolicy::reject>
+class RingBuffer{
+private:
+    static constexpr std::size_t kMask = Cap - 1;
+
+public:
+    static_assert((Cap & (Cap - 1)) == 0, "Cap must be power of two.");
+    RingBuffer(){
+        for(std::size_t i = 0; i < Cap; ++i){
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~RingBuffer()=default;
+    RingBuffer(const RingBuffer&)=delete;
+    RingBuffer& operator=(const RingBuffer&)=delete;
+    RingBuffer(RingBuffer&&)=delete;
+    RingBuffer& operator=(RingBuffer&&)=delete;
+
+    // Under FullPolicy::block this waits for room and always returns true.
+    bool try_enqueue(const EleType& ele){
+        return enqueue_impl(ele);
+    }
+    bool try_enqueue(EleType&& ele){
+        return enqueue_impl(std::move(ele));
+    }
 
+    // Consumer side; call from one thread only.
+    bool try_dequeue(EleType& out){
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[head & kMask];
+        if(slot.seq.load(std::memory_order_acquire) != head + 1){
+            return false;
+        }
+        out = std::move(slot.ele_);
+        slot.seq.store(head + Cap, std::memory_order_release);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // Moves up to max published elements to out and returns how many.
+    template <typename OutputIt>
+    std::size_t try_dequeue_bulk(OutputIt out, std::size_t max){
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t n = 0;
+        for(; n < max; ++n, ++out){
+            Slot& slot = slots_[(head + n) & kMask];
+            if(slot.seq.load(std::memory_order_acquire) != head + n + 1){
+                break;
+            }
+            *out = std::move(slot.ele_);
+            slot.seq.store(head + n + Cap, std::memory_order_release);
+        }
+        if(n != 0){
+            head_.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
 
 private:
     struct Slot{
         std::atomic<std::size_t> seq{0};
         EleType ele_;
     };
-    alignas(64) std::atomic<std::size_t> head_;
-    alignas(64) std::atomic<std::size_t> tail_;
+
+    template <typename U>
+    bool enqueue_impl(U&& ele){
+        if constexpr(Policy == FullPolicy::reject){
+            // reserved_ never falls below the number of successful
+            // reservations, so passing this check bounds every claimed
+            // position below head + Cap: the slot was already released and
+            // the wait below can only see the consumer's store land. A
+            // check on tail_ before the fetch_add would not be atomic with
+            // it and could claim a slot one lap ahead. The consumer may move
+            // past a reserved value between the two operations, so compare
+            // the difference signed.
+            const std::size_t reserved = reserved_.fetch_add(1, std::memory_order_relaxed);
+            const std::size_t head = head_.load(std::memory_order_acquire);
+            if(static_cast<std::ptrdiff_t>(reserved - head) >= static_cast<std::ptrdiff_t>(Cap)){
+                reserved_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        const std::size_t pos = tail_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[pos & kMask];
+        for(unsigned spins = 0; slot.seq.load(std::memory_order_acquire) != pos; ++spins){
+            if(spins < 64){
+                detail::cpu_relax();
+            }else{
+                std::this_thread::yield();
+            }
+        }
+        slot.ele_ = std::forward<U>(ele);
+        slot.seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    // Only touched under FullPolicy::reject.
+    alignas(64) std::atomic<std::size_t> reserved_{0};
     std::array<Slot, Cap> slots_;
 };
 
+}
+
+namespace SPSC{
+
+// Single-producer single-consumer ring. Each side owns one index and keeps a
+// cached copy of the other's, so the shared index is only loaded when the
+// cached view says full (producer) or empty (consumer). The bulk calls
+// publish a whole batch with one release store.
+template <typename EleType, std::size_t Cap>
+class RingBuffer{
+private:
+    static constexpr std::size_t kMask = Cap - 1;
+
+public:
+    static_assert((Cap & (Cap - 1)) == 0, "Cap must be power of two.");
+    RingBuffer()=default;
+    ~RingBuffer()=default;
+    RingBuffer(const RingBuffer&)=delete;
+    RingBuffer& operator=(const RingBuffer&)=delete;
+    RingBuffer(RingBuffer&&)=delete;
+    RingBuffer& operator=(RingBuffer&&)=delete;
+
+    bool try_enqueue(const EleType& ele){
+        return enqueue_impl(ele);
+    }
+    bool try_enqueue(EleType&& ele){
+        return enqueue_impl(std::move(ele));
+    }
+    // Writes as many of [first, last) as fit and returns how many.
+    template <typename InputIt>
+    std::size_t try_enqueue_bulk(InputIt first, InputIt last){
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t free = Cap - (tail - head_cache_);
+        std::size_t n = 0;
+        for(; first != last; ++first, ++n){
+            if(n == free){
+                head_cache_ = head_.load(std::memory_order_acquire);
+                free = Cap - (tail - head_cache_);
+                if(n == free){
+                    break;
+                }
+            }
+            slots_[(tail + n) & kMask] = *first;
+        }
+        if(n != 0){
+            tail_.store(tail + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    bool try_dequeue(EleType& out){
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_cache_){
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if(head == tail_cache_){
+                return false;
+            }
+        }
+        out = std::move(slots_[head & kMask]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // Moves up to max elements to out and returns how many.
+    template <typename OutputIt>
+    std::size_t try_dequeue_bulk(OutputIt out, std::size_t max){
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t avail = tail_cache_ - head;
+        if(avail < max){
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            avail = tail_cache_ - head;
+        }
+        const std::size_t n = avail < max ? avail : max;
+        for(std::size_t i = 0; i < n; ++i, ++out){
+            *out = std::move(slots_[(head + i) & kMask]);
+        }
+        if(n != 0){
+            head_.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
 
+private:
+    template <typename U>
+    bool enqueue_impl(U&& ele){
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_cache_ == Cap){
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if(tail - head_cache_ == Cap){
+                return false;
+            }
+        }
+        slots_[tail & kMask] = std::forward<U>(ele);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer line: its index and its view of the consumer.
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_{0};
+    // Consumer line.
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_{0};
+    alignas(64) std::array<EleType, Cap> slots_{};
+};
 
 }
 }
@@ -0,0 +1,210 @@
+#ifndef ATOMIC_SEGMENT_QUEUE_HPP
+#define ATOMIC_SEGMENT_QUEUE_HPP
+
+#include "atomic_epoch.hpp"
+#include "backoff.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+namespace atomic{
+
+// Unbounded MPMC queue built from linked segments of fixed-size slot arrays.
+// Producers and consumers claim slot indices with fetch_add; a consumer that
+// overtakes a producer poisons the slot and the producer retries elsewhere.
+// Drained segments are reclaimed through detail::EpochManager, so there is
+// one allocation per SegmentSize elements instead of one per element.
+// Backoff is applied after a lost slot or a failed CAS on head_ or on the
+// tail link.
+template <typename T, std::size_t SegmentSize = 1024, typename Backoff = backoff::None>
+class SegmentQueue {
+public:
+  static_assert(SegmentSize > 0, "SegmentSize must be positive.");
+
+  SegmentQueue()
+      : head_(new Segment()),
+        tail_(head_.load(std::memory_order_relaxed)) {}
+
+  ~SegmentQueue() {
+    epoch_.shutdown();
+    Segment* seg = head_.load(std::memory_order_relaxed);
+    while (seg) {
+      Segment* next = seg->next.load(std::memory_order_relaxed);
+      destroy_segment(seg);
+      seg = next;
+    }
+  }
+
+  SegmentQueue(const SegmentQueue&) = delete;
+  SegmentQueue& operator=(const SegmentQueue&) = delete;
+  SegmentQueue(SegmentQueue&&) = delete;
+  SegmentQueue& operator=(SegmentQueue&&) = delete;
+
+  // Always succeeds; returns bool so generic code written against
+  // Queue::enqueue works with either queue.
+  bool enqueue(const T& value) {
+    enqueue_impl(T(value));
+    return true;
+  }
+
+  bool enqueue(T&& value) {
+    enqueue_impl(std::move(value));
+    return true;
+  }
+
+  [[nodiscard]] bool try_dequeue(T& out) {
+    EpochGuard guard(epoch_);
+    Backoff backoff;
+    for (;;) {
+      Segment* head = head_.load(std::memory_order_acquire);
+      if (head->deq_idx.load(std::memory_order_relaxed) >=
+              head->enq_idx.load(std::memory_order_relaxed) &&
+          head->next.load(std::memory_order_acquire) == nullptr) {
+        return false;
+      }
+      const std::size_t idx = head->deq_idx.fetch_add(1, std::memory_order_relaxed);
+      if (idx >= SegmentSize) {
+        Segment* next = head->next.load(std::memory_order_acquire);
+        if (!next) {
+          return false;
+        }
+        // Keep tail_ from being left on a segment that is about to retire.
+        Segment* tail = tail_.load(std::memory_order_acquire);
+        if (tail == head) {
+          tail_.compare_exchange_strong(
+              tail, next,
+              std::memory_order_release,
+              std::memory_order_relaxed);
+        }
+        if (head_.compare_exchange_strong(
+                head, next,
+                std::memory_order_release,
+                std::memory_order_relaxed)) {
+          epoch_.retire(head);
+        } else {
+          backoff();
+        }
+        continue;
+      }
+      Slot& slot = head->slots[idx];
+      if (slot.state.exchange(kTaken, std::memory_order_acq_rel) == kFull) {
+        T* value = slot.ptr();
+        out = std::move(*value);
+        value->~T();
+        return true;
+      }
+      backoff();
+    }
+  }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+  static constexpr uint32_t kEmpty = 0;
+  static constexpr uint32_t kFull = 1;
+  static constexpr uint32_t kTaken = 2;
+
+  struct Slot {
+    std::atomic<uint32_t> state{kEmpty};
+    alignas(T) unsigned char storage[sizeof(T)];
+    T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  struct Segment {
+    alignas(kCacheLine) std::atomic<std::size_t> enq_idx{0};
+    alignas(kCacheLine) std::atomic<std::size_t> deq_idx{0};
+    alignas(kCacheLine) std::atomic<Segment*> next{nullptr};
+    Slot slots[SegmentSize];
+  };
+
+  using Epoch = detail::EpochManager<SegmentQueue, Segment, Backoff>;
+  using ThreadRecord = typename Epoch::ThreadRecord;
+  using EpochGuard = typename Epoch::Guard;
+  friend Epoch;
+
+  void enqueue_impl(T&& value) {
+    EpochGuard guard(epoch_);
+    Backoff backoff;
+    for (;;) {
+      Segment* tail = tail_.load(std::memory_order_acquire);
+      const std::size_t idx = tail->enq_idx.fetch_add(1, std::memory_order_relaxed);
+      if (idx < SegmentSize) {
+        Slot& slot = tail->slots[idx];
+        T* placed = new (slot.storage) T(std::move(value));
+        uint32_t expected = kEmpty;
+        if (slot.state.compare_exchange_strong(
+                expected, kFull,
+                std::memory_order_release,
+                std::memory_order_relaxed)) {
+          return;
+        }
+        // A consumer poisoned this slot first; take the value back and retry.
+        value = std::move(*placed);
+        placed->~T();
+        backoff();
+        continue;
+      }
+      if (tail != tail_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      Segment* next = tail->next.load(std::memory_order_acquire);
+      if (next) {
+        tail_.compare_exchange_strong(
+            tail, next,
+            std::memory_order_release,
+            std::memory_order_relaxed);
+        continue;
+      }
+      // Open a new segment with the value already in slot 0.
+      Segment* seg = new Segment();
+      T* placed = new (seg->slots[0].storage) T(std::move(value));
+      seg->slots[0].state.store(kFull, std::memory_order_relaxed);
+      seg->enq_idx.store(1, std::memory_order_relaxed);
+      if (tail->next.compare_exchange_strong(
+              next, seg,
+              std::memory_order_release,
+              std::memory_order_acquire)) {
+        tail_.compare_exchange_strong(
+            tail, seg,
+            std::memory_order_release,
+            std::memory_order_relaxed);
+        return;
+      }
+      value = std::move(*placed);
+      placed->~T();
+      delete seg;
+      tail_.compare_exchange_strong(
+          tail, next,
+          std::memory_order_release,
+          std::memory_order_relaxed);
+      backoff();
+    }
+  }
+
+  static void destroy_segment(Segment* seg) {
+    for (auto& slot : seg->slots) {
+      if (slot.state.load(std::memory_order_relaxed) == kFull) {
+        slot.ptr()->~T();
+      }
+    }
+    delete seg;
+  }
+
+  // EpochManager hooks. Retired segments hold no live values: every index
+  // was claimed by a consumer that either took the value or poisoned it.
+  void reclaim_node(Segment* seg) {
+    delete seg;
+  }
+
+  void orphan_local_cache(ThreadRecord*) {}
+
+  void drain_local_cache(ThreadRecord*) {}
+
+  Epoch epoch_{this};
+  alignas(kCacheLine) std::atomic<Segment*> head_;
+  alignas(kCacheLine) std::atomic<Segment*> tail_;
+};
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ATOMIC_STATUS_HPP
+#define ATOMIC_STATUS_HPP
+
+namespace atomic{
+
+// Outcome of a dequeue on a closable container. closed is only reported
+// once close() has been called and everything enqueued before it has been
+// dequeued, so a consumer can stop as soon as it sees it.
+enum class DequeueStatus{
+    ok,
+    empty,
+    closed,
+};
+
+}
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef ATOMIC_TOPOLOGY_HPP
+#define ATOMIC_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace atomic{
+
+// Pins the calling thread to one logical CPU. Returns false if the
+// platform has no affinity API or the kernel refused.
+inline bool pin_thread(int cpu){
+#ifdef __linux__
+    if(cpu < 0 || cpu >= CPU_SETSIZE){
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// How the two threads of a communicating pair are placed relative to each
+// other.
+enum class Placement{
+    smt_sibling,    // two hardware threads of one physical core
+    same_socket,    // different cores of one package
+    cross_socket,   // cores in different packages
+};
+
+inline const char* placement_name(Placement p){
+    switch(p){
+    case Placement::smt_sibling: return "smt_sibling";
+    case Placement::same_socket: return "same_socket";
+    case Placement::cross_socket: return "cross_socket";
+    }
+    return "?";
+}
+
+struct CpuInfo{
+    int cpu;
+    int core;       // core_id, unique only within its package
+    int package;    // physical_package_id
+    int node;       // NUMA node, 0 if the kernel has no NUMA information
+};
+
+// Online CPUs with their core, package and NUMA node, read from sysfs
+// (<root>/cpu and <root>/node). Where sysfs is missing, every CPU reported
+// by hardware_concurrency() is treated as its own core on package 0.
+class Topology{
+public:
+    static Topology detect(const std::string& root = "/sys/devices/system"){
+        Topology t;
+        std::vector<int> online = parse_cpu_list(read_line(root + "/cpu/online"));
+        if(online.empty()){
+            const int n = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+            for(int cpu = 0; cpu < n; ++cpu){
+                t.cpus_.push_back(CpuInfo{cpu, cpu, 0, 0});
+            }
+            return t;
+        }
+        std::map<int, int> node_of;
+#ifdef __linux__
+        if(DIR* dir = opendir((root + "/node").c_str())){
+            while(dirent* e = readdir(dir)){
+                int node;
+                char tail;
+                if(std::sscanf(e->d_name, "node%d%c", &node, &tail) != 1){
+                    continue;
+                }
+                for(int cpu : parse_cpu_list(read_line(root + "/node/" + e->d_name + "/cpulist"))){
+                    node_of[cpu] = node;
+                }
+            }
+            closedir(dir);
+        }
+#endif
+        for(int cpu : online){
+            const std::string dir = root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            CpuInfo info{cpu, cpu, 0, 0};
+            read_int(dir + "core_id", info.core);
+            read_int(dir + "physical_package_id", info.package);
+            auto it = node_of.find(cpu);
+            if(it != node_of.end()){
+                info.node = it->second;
+            }
+            t.cpus_.push_back(info);
+        }
+        return t;
+    }
+
+    const std::vector<CpuInfo>& cpus() const{ return cpus_; }
+
+    std::size_t packages() const{
+        std::vector<int> ids;
+        for(const CpuInfo& c : cpus_){
+            ids.push_back(c.package);
+        }
+        std::sort(ids.begin(), ids.end());
+        return static_cast<std::size_t>(std::unique(ids.begin(), ids.end()) - ids.begin());
+    }
+
+    // CPUs for `pairs` communicating pairs: element 2k and 2k+1 are pair k
+    // and stand in relation p to each other, and no CPU is used twice.
+    // Returns an empty vector if the machine cannot provide that many.
+    std::vector<int> assign(Placement p, std::size_t pairs) const{
+        // package -> core -> hardware threads, all in ascending order.
+        std::map<int, std::map<int, std::vector<int>>> tree;
+        for(const CpuInfo& c : cpus_){
+            tree[c.package][c.core].push_back(c.cpu);
+        }
+        std::vector<int> out;
+        switch(p){
+        case Placement::smt_sibling:
+            for(auto& pkg : tree){
+                for(auto& core : pkg.second){
+                    const std::vector<int>& threads = core.second;
+                    for(std::size_t i = 0; i + 1 < threads.size(); i += 2){
+                        out.push_back(threads[i]);
+                        out.push_back(threads[i + 1]);
+                    }
+                }
+            }
+            break;
+        case Placement::same_socket:
+            for(auto& pkg : tree){
+                std::vector<int> firsts = first_threads(pkg.second);
+                for(std::size_t i = 0; i + 1 < firsts.size(); i += 2){
+                    out.push_back(firsts[i]);
+                    out.push_back(firsts[i + 1]);
+                }
+            }
+            break;
+        case Placement::cross_socket: {
+            // Pair package 0 with 1, 2 with 3, ...; cores matched by rank.
+            std::vector<std::vector<int>> pkgs;
+            for(auto& pkg : tree){
+                pkgs.push_back(first_threads(pkg.second));
+            }
+            for(std::size_t i = 0; i + 1 < pkgs.size(); i += 2){
+                const std::size_t n = std::min(pkgs[i].size(), pkgs[i + 1].size());
+                for(std::size_t j = 0; j < n; ++j){
+                    out.push_back(pkgs[i][j]);
+                    out.push_back(pkgs[i + 1][j]);
+                }
+            }
+            break;
+        }
+        }
+        if(out.size() < 2 * pairs){
+            return {};
+        }
+        out.resize(2 * pairs);
+        return out;
+    }
+
+    // Parses a sysfs CPU list such as "0-3,8,10-11". Returns an empty
+    // vector if the list is malformed.
+    static std::vector<int> parse_cpu_list(const std::string& list){
+        std::vector<int> out;
+        const char* p = list.c_str();
+        while(*p != '\0'){
+            char* end;
+            const long lo = std::strtol(p, &end, 10);
+            long hi = lo;
+            if(end == p || lo < 0){
+                return {};
+            }
+            p = end;
+            if(*p == '-'){
+                hi = std::strtol(p + 1, &end, 10);
+                if(end == p + 1 || hi < lo){
+                    return {};
+                }
+                p = end;
+            }
+            for(long cpu = lo; cpu <= hi; ++cpu){
+                out.push_back(static_cast<int>(cpu));
+            }
+            if(*p == ','){
+                ++p;
+            }else if(*p != '\0' && *p != '\n'){
+                return {};
+            }else{
+                break;
+            }
+        }
+        return out;
+    }
+
+private:
+    static std::string read_line(const std::string& path){
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+    static void read_int(const std::string& path, int& out){
+        std::ifstream in(path);
+        int v;
+        if(in >> v){
+            out = v;
+        }
+    }
+    // The first hardware thread of every core, so each gets a core to itself.
+    static std::vector<int> first_threads(const std::map<int, std::vector<int>>& cores){
+        std::vector<int> out;
+        for(auto& core : cores){
+            out.push_back(core.second.front());
+        }
+        return out;
+    }
+
+    std::vector<CpuInfo> cpus_;
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef BACKOFF_HPP
+#define BACKOFF_HPP
+
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace atomic{
+namespace detail{
+
+inline void cpu_relax(){
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+}
+
+// Backoff policies for compare-exchange retry loops. A loop makes one policy
+// object per operation and calls it after every failed compare_exchange, so
+// under contention threads spread their retries out instead of hammering
+// the same cache line. None keeps the plain retry loop.
+namespace backoff{
+
+struct None{
+    void operator()(){}
+};
+
+// One pause instruction per failed attempt.
+struct Pause{
+    void operator()(){
+        detail::cpu_relax();
+    }
+};
+
+// Pauses 1, 2, 4, ... times per failed attempt, capped at MaxSpins.
+template <unsigned MaxSpins = 256>
+struct Exponential{
+    void operator()(){
+        for(unsigned i = 0; i < spins_; ++i){
+            detail::cpu_relax();
+        }
+        if(spins_ < MaxSpins){
+            spins_ *= 2;
+        }
+    }
+
+private:
+    unsigned spins_{1};
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef BENCH_HISTOGRAM_HPP
+#define BENCH_HISTOGRAM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace bench {
+
+// Log-linear latency histogram: every power-of-two range is split into
+// kSub equal buckets, so values are kept to within ~3% in a fixed 15 KiB
+// table with O(1) record(). Use one per thread and merge afterwards.
+class Histogram {
+ public:
+  static constexpr int kSubBits = 5;
+  static constexpr std::size_t kSub = std::size_t{1} << kSubBits;
+  static constexpr std::size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+  void record(uint64_t value) {
+    ++buckets_[index(value)];
+    ++count_;
+    sum_ += value;
+    if (value > max_) {
+      max_ = value;
+    }
+  }
+
+  void merge(const Histogram& other) {
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.max_ > max_) {
+      max_ = other.max_;
+    }
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t max() const { return max_; }
+  double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+  // Upper bound of the bucket holding the p-th percentile, p in [0, 100].
+  uint64_t percentile(double p) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * count_ + 0.5);
+    if (rank == 0) {
+      rank = 1;
+    }
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        const uint64_t upper = upper_bound(i);
+        return upper < max_ ? upper : max_;
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static std::size_t index(uint64_t value) {
+    if (value < kSub) {
+      return static_cast<std::size_t>(value);
+    }
+    const int msb = 63 - __builtin_clzll(value);
+    const int shift = msb - kSubBits;
+    return (shift + 1) * kSub + static_cast<std::size_t>((value >> shift) - kSub);
+  }
+
+  static uint64_t upper_bound(std::size_t idx) {
+    if (idx < kSub) {
+      return idx;
+    }
+    const int shift = static_cast<int>(idx / kSub) - 1;
+    const uint64_t sub = idx % kSub;
+    return ((kSub + sub + 1) << shift) - 1;
+  }
+
+  std::array<uint64_t, kBuckets> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t max_ = 0;
+};
+
+}  // namespace bench
+
+#endif
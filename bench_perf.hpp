@@ -0,0 +1,148 @@
+#ifndef BENCH_PERF_HPP
+#define BENCH_PERF_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+enum PerfEvent { kCycles, kInstructions, kL1dMisses, kLlcMisses, kHitm, kPerfEvents };
+
+inline const char* perf_event_name(int e) {
+  static const char* const names[kPerfEvents] = {"cycles", "instructions", "l1d_misses",
+                                                 "llc_misses", "hitm"};
+  return names[e];
+}
+
+// Counter totals. valid[e] is false when event e could not be opened, so
+// callers print only what the machine actually measured.
+struct PerfSample {
+  std::array<uint64_t, kPerfEvents> values{};
+  std::array<bool, kPerfEvents> valid{};
+
+  void merge(const PerfSample& other) {
+    for (int e = 0; e < kPerfEvents; ++e) {
+      values[e] += other.values[e];
+      valid[e] = valid[e] || other.valid[e];
+    }
+  }
+  bool any() const {
+    for (bool v : valid) {
+      if (v) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// Hardware counters for the calling thread, opened with perf_event_open.
+// Each event that fails to open (no PMU in a container or VM,
+// perf_event_paranoid too strict, non-Linux) is just left out. HITM has
+// no generic encoding, so it is only counted when BENCH_PERF_HITM holds
+// the raw event config for this CPU, e.g. 0x04d2 on Skylake
+// (MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM). Counts are scaled when the kernel
+// multiplexes the counters.
+class PerfCounters {
+ public:
+  PerfCounters() {
+    fds_.fill(-1);
+#ifdef __linux__
+    open_event(kCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open_event(kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open_event(kL1dMisses, PERF_TYPE_HW_CACHE,
+               PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    open_event(kLlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    if (const char* hitm = std::getenv("BENCH_PERF_HITM")) {
+      open_event(kHitm, PERF_TYPE_RAW, std::strtoull(hitm, nullptr, 0));
+    }
+#endif
+  }
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // True if at least one event opened.
+  bool available() const {
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void start() {
+#ifdef __linux__
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  // Stops counting and returns the totals since start().
+  PerfSample stop() {
+    PerfSample s;
+#ifdef __linux__
+    for (int e = 0; e < kPerfEvents; ++e) {
+      if (fds_[e] < 0) {
+        continue;
+      }
+      ioctl(fds_[e], PERF_EVENT_IOC_DISABLE, 0);
+      // value, time_enabled, time_running
+      uint64_t buf[3];
+      if (::read(fds_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)) || buf[2] == 0) {
+        continue;
+      }
+      s.values[e] = buf[2] < buf[1]
+                        ? static_cast<uint64_t>(static_cast<double>(buf[0]) * buf[1] / buf[2])
+                        : buf[0];
+      s.valid[e] = true;
+    }
+#endif
+    return s;
+  }
+
+ private:
+#ifdef __linux__
+  void open_event(int e, uint32_t type, uint64_t config) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fds_[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+
+  std::array<int, kPerfEvents> fds_;
+};
+
+}  // namespace bench
+
+#endif
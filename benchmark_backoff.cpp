@@ -0,0 +1,139 @@
+#include "atomic_clamp.hpp"
+#include "atomic_min_max.hpp"
+#include "atomic_queue.hpp"
+#include "atomic_ring.hpp"
+#include "atomic_segment_queue.hpp"
+#include "backoff.hpp"
+#include "bound_counter.hpp"
+#include "bucket.hpp"
+#include "rate_limiter_counter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Runs op(thread_index, iteration) on every thread for a fixed time and
+// returns total operations per second.
+template <typename Op>
+static double run_threads(int threads, double seconds, Op op) {
+  std::atomic<bool> start{false};
+  std::atomic<bool> stop{false};
+  std::vector<int64_t> counts(threads, 0);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      int64_t n = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        op(t, n);
+        ++n;
+      }
+      counts[t] = n;
+    });
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop.store(true, std::memory_order_relaxed);
+  for (auto& w : workers) {
+    w.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - t0;
+  int64_t total = 0;
+  for (int64_t c : counts) {
+    total += c;
+  }
+  return total / elapsed.count();
+}
+
+static void print_row(const char* primitive, const char* policy, int threads, double ops) {
+  std::cout << primitive << "," << policy << "," << threads << "," << ops << "\n";
+}
+
+template <typename Backoff>
+static void bench_policy(const char* policy, int threads, double seconds) {
+  {
+    // Add then subtract so the counter never saturates.
+    atomic::BoundCounter<int64_t, Backoff> c(std::numeric_limits<int64_t>::max() / 2);
+    print_row("BoundCounter", policy, threads, run_threads(threads, seconds, [&](int, int64_t) {
+      (void)c.try_add(1);
+      (void)c.try_sub(1);
+    }));
+  }
+  {
+    // Every thread keeps raising the maximum, so most CASes contend.
+    atomic::MinMax<int64_t, Backoff> mm(0);
+    print_row("MinMax", policy, threads, run_threads(threads, seconds, [&](int t, int64_t i) {
+      (void)mm.update_max(i * 64 + t);
+    }));
+  }
+  {
+    atomic::Clamp<int64_t, Backoff> clamp(0);
+    print_row("Clamp", policy, threads, run_threads(threads, seconds, [&](int, int64_t i) {
+      clamp.clamp_to(i & 1, (i & 1) + 1);
+      clamp.clamp_to(4, 5);
+    }));
+  }
+  {
+    atomic::BasicBucket<Backoff> bucket(1, 1e12, 1e12);
+    print_row("Bucket", policy, threads, run_threads(threads, seconds, [&](int, int64_t) {
+      (void)bucket.consume(1.0);
+    }));
+  }
+  {
+    atomic::BasicRateLimiterCounter<Backoff> rl(1, std::numeric_limits<int>::max());
+    print_row("RateLimiterCounter", policy, threads, run_threads(threads, seconds, [&](int, int64_t) {
+      (void)rl.allow();
+    }));
+  }
+  {
+    atomic::Queue<int, Backoff> q;
+    print_row("Queue", policy, threads, run_threads(threads, seconds, [&](int, int64_t i) {
+      int out;
+      q.enqueue(static_cast<int>(i));
+      (void)q.try_dequeue(out);
+    }));
+  }
+  {
+    atomic::SegmentQueue<int, 1024, Backoff> q;
+    print_row("SegmentQueue", policy, threads, run_threads(threads, seconds, [&](int, int64_t i) {
+      int out;
+      q.enqueue(static_cast<int>(i));
+      (void)q.try_dequeue(out);
+    }));
+  }
+  {
+    auto ring = std::make_unique<atomic::MPMC::RingBuffer<int, 1 << 12, atomic::MPMC::layout::Packed, Backoff>>();
+    print_row("RingBuffer", policy, threads, run_threads(threads, seconds, [&](int, int64_t i) {
+      int out;
+      (void)ring->try_enqueue(static_cast<int>(i));
+      (void)ring->try_dequeue(out);
+    }));
+  }
+}
+
+// Usage: benchmark_backoff [max_threads] [seconds_per_run]
+// Prints CSV: primitive,policy,threads,ops_per_sec for 1, 2, 4, ... threads.
+int main(int argc, char** argv) {
+  int max_threads = 64;
+  double seconds = 0.5;
+  if (argc >= 2) max_threads = std::atoi(argv[1]);
+  if (argc >= 3) seconds = std::atof(argv[2]);
+
+  std::cout << "primitive,policy,threads,ops_per_sec\n";
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    bench_policy<atomic::backoff::None>("none", threads, seconds);
+    bench_policy<atomic::backoff::Pause>("pause", threads, seconds);
+    bench_policy<atomic::backoff::Exponential<>>("exponential", threads, seconds);
+  }
+  return 0;
+}
@@ -1,4 +1,7 @@
 #include "atomic_ring.hpp"
+#include "atomic_topology.hpp"
+#include "bench_histogram.hpp"
+#include "bench_perf.hpp"
 
 #include <atomic>
 #include <chrono>
@@ -8,21 +11,24 @@
 #include <memory>
 #include <mutex>
 #include <queue>
-#include <pthread.h>
-#include <sched.h>
+#include <string>
 #include <thread>
 #include <vector>
 
-constexpr std::size_t kCap = 1 << 30;
+// Ring size for the throughput comparison. The inline RingQueue is
+// heap-constructed and touched slot by slot, so it stays at a size every
+// machine can build; DynRingQueue gets the same capacity for a fair match.
+constexpr std::size_t kCap = 1 << 20;
 
-struct MutexQueue {
-  bool try_enqueue(int v) {
+template <typename T>
+struct BasicMutexQueue {
+  bool try_enqueue(T v) {
     std::lock_guard<std::mutex> lock(mu_);
     q_.push(v);
     return true;
   }
 
-  bool try_dequeue(int& out) {
+  bool try_dequeue(T& out) {
     std::lock_guard<std::mutex> lock(mu_);
     if (q_.empty()) {
       return false;
@@ -33,56 +39,84 @@ struct MutexQueue {
   }
 
   std::mutex mu_;
-  std::queue<int> q_;
+  std::queue<T> q_;
 };
 
+using MutexQueue = BasicMutexQueue<int>;
+
 using RingQueue = atomic::MPMC::RingBuffer<int, kCap>;
 
+// Ring size for the layout comparison: small enough that the ring stays in
+// cache and slot layout, not memory bandwidth, decides the result.
+constexpr std::size_t kLayoutCap = 1 << 12;
+using PackedRing = atomic::MPMC::RingBuffer<int, kLayoutCap, atomic::MPMC::layout::Packed>;
+using PaddedRing = atomic::MPMC::RingBuffer<int, kLayoutCap, atomic::MPMC::layout::Padded>;
+using RemappedRing = atomic::MPMC::RingBuffer<int, kLayoutCap, atomic::MPMC::layout::Remapped>;
+
+using SpscRing = atomic::SPSC::RingBuffer<int, kLayoutCap>;
+using MpscRing = atomic::MPSC::RingBuffer<int, kLayoutCap>;
+
+struct DynRingQueue : atomic::MPMC::DynamicRingBuffer<int> {
+  DynRingQueue() : DynamicRingBuffer(kCap, atomic::HugePages::transparent) {}
+};
+
+// Latency mode carries a send timestamp in every element.
+using LatMpmcRing = atomic::MPMC::RingBuffer<uint64_t, kLayoutCap>;
+using LatSpscRing = atomic::SPSC::RingBuffer<uint64_t, kLayoutCap>;
+using LatMpscRing = atomic::MPSC::RingBuffer<uint64_t, kLayoutCap>;
+using LatMutexQueue = BasicMutexQueue<uint64_t>;
+
 struct BenchResult {
   const char* name;
   int64_t produced;
   int64_t consumed;
   double seconds;
+  bench::PerfSample perf;
 };
 
-static void pin_thread(std::size_t cpu) {
-#ifdef __linux__
-  cpu_set_t set;
-  CPU_ZERO(&set);
-  CPU_SET(static_cast<int>(cpu), &set);
-  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
-#else
-  (void)cpu;
-#endif
+// CPU for thread `slot` (producers first, then consumers). With an explicit
+// placement, producer i and consumer i are pinned to cpus[2i] and
+// cpus[2i+1]; otherwise threads are spread round-robin.
+static int cpu_for(const std::vector<int>& cpus, int producers, int slot) {
+  if (!cpus.empty()) {
+    const int pair = slot < producers ? slot : slot - producers;
+    return cpus[(2 * pair + (slot < producers ? 0 : 1)) % cpus.size()];
+  }
+  return slot % static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
 }
 
 template <typename Queue>
-static BenchResult run_bench(const char* name, int producers, int consumers, int seconds) {
+static BenchResult run_bench(const char* name, int producers, int consumers, int seconds,
+                             const std::vector<int>& cpus = {}) {
   auto q = std::make_unique<Queue>();
   std::atomic<bool> start{false};
   std::atomic<int> phase{0};
-  const std::size_t cpu_count = std::max(1u, std::thread::hardware_concurrency());
   std::vector<int64_t> produced_counts(producers, 0);
   std::vector<int64_t> consumed_counts(consumers, 0);
+  std::vector<bench::PerfSample> perf(producers + consumers);
 
   std::vector<std::thread> threads;
   threads.reserve(producers + consumers);
 
   for (int i = 0; i < producers; ++i) {
     threads.emplace_back([&, i]() {
-      if (cpu_count > 0) {
-        pin_thread(static_cast<std::size_t>(i) % cpu_count);
-      }
+      atomic::pin_thread(cpu_for(cpus, producers, i));
+      bench::PerfCounters counters;
       while (!start.load(std::memory_order_acquire)) {
         std::this_thread::yield();
       }
       int v = 0;
       int64_t local_count = 0;
+      bool counting = false;
       for (;;) {
         const int cur_phase = phase.load(std::memory_order_relaxed);
         if (cur_phase == 2) {
           break;
         }
+        if (cur_phase == 1 && !counting) {
+          counters.start();
+          counting = true;
+        }
         if (q->try_enqueue(v++)) {
           if (cur_phase == 1) {
             ++local_count;
@@ -91,25 +125,32 @@ static BenchResult run_bench(const char* name, int producers, int consumers, int
           std::this_thread::yield();
         }
       }
+      if (counting) {
+        perf[i] = counters.stop();
+      }
       produced_counts[i] = local_count;
     });
   }
 
   for (int i = 0; i < consumers; ++i) {
     threads.emplace_back([&, i]() {
-      if (cpu_count > 0) {
-        pin_thread(static_cast<std::size_t>(producers + i) % cpu_count);
-      }
+      atomic::pin_thread(cpu_for(cpus, producers, producers + i));
+      bench::PerfCounters counters;
       while (!start.load(std::memory_order_acquire)) {
         std::this_thread::yield();
       }
       int out = 0;
       int64_t local_count = 0;
+      bool counting = false;
       for (;;) {
         const int cur_phase = phase.load(std::memory_order_relaxed);
         if (cur_phase == 2) {
           break;
         }
+        if (cur_phase == 1 && !counting) {
+          counters.start();
+          counting = true;
+        }
         if (q->try_dequeue(out)) {
           if (cur_phase == 1) {
             ++local_count;
@@ -118,6 +159,9 @@ static BenchResult run_bench(const char* name, int producers, int consumers, int
           std::this_thread::yield();
         }
       }
+      if (counting) {
+        perf[producers + i] = counters.stop();
+      }
       consumed_counts[i] = local_count;
     });
   }
@@ -142,8 +186,12 @@ static BenchResult run_bench(const char* name, int producers, int consumers, int
   for (int64_t v : consumed_counts) {
     consumed += v;
   }
+  bench::PerfSample total;
+  for (const bench::PerfSample& p : perf) {
+    total.merge(p);
+  }
   const std::chrono::duration<double> elapsed = t1 - t0;
-  return BenchResult{name, produced, consumed, elapsed.count()};
+  return BenchResult{name, produced, consumed, elapsed.count(), total};
 }
 
 static void print_result(const BenchResult& r) {
@@ -151,10 +199,203 @@ static void print_result(const BenchResult& r) {
   std::cout << r.name << ": produced=" << r.produced
             << " consumed=" << r.consumed
             << " seconds=" << r.seconds
-            << " ops/s=" << ops << "\n";
+            << " ops/s=" << ops;
+  // Counters are summed over producers and consumers and divided by the
+  // number of elements that made it through, i.e. the cost of one transfer.
+  if (r.perf.any() && r.consumed > 0) {
+    for (int e = 0; e < bench::kPerfEvents; ++e) {
+      if (r.perf.valid[e]) {
+        std::cout << " " << bench::perf_event_name(e)
+                  << "/op=" << static_cast<double>(r.perf.values[e]) / r.consumed;
+      }
+    }
+  }
+  std::cout << "\n";
+}
+
+struct LatencyResult {
+  const char* name;
+  bench::Histogram hist;
+  double seconds;
+};
+
+static uint64_t now_ns(std::chrono::steady_clock::time_point base) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - base)
+          .count());
+}
+
+// Measures enqueue-to-dequeue latency. Every element is the time it was
+// meant to be sent, and consumers record now - stamp into a per-thread
+// histogram. rate == 0 runs producers closed-loop (stamp just before each
+// enqueue). rate > 0 runs each producer open-loop at `rate` elements per
+// second. Element k is stamped with its scheduled time, not the time the
+// producer got to it, so a stall shows up in the latency of everything
+// queued behind it instead of silently lowering the send rate
+// (coordinated omission).
+template <typename Queue>
+static LatencyResult run_latency(const char* name, int producers, int consumers, int seconds,
+                                 double rate) {
+  auto q = std::make_unique<Queue>();
+  std::atomic<bool> start{false};
+  std::atomic<int> phase{0};
+  std::vector<bench::Histogram> hists(consumers);
+  const auto base = std::chrono::steady_clock::now();
+  const double interval_ns = rate > 0 ? 1e9 / rate : 0;
+
+  std::vector<std::thread> threads;
+  threads.reserve(producers + consumers);
+
+  for (int i = 0; i < producers; ++i) {
+    threads.emplace_back([&, i]() {
+      atomic::pin_thread(cpu_for({}, producers, i));
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      const uint64_t first = now_ns(base);
+      for (uint64_t k = 0; phase.load(std::memory_order_relaxed) != 2; ++k) {
+        uint64_t stamp;
+        if (interval_ns > 0) {
+          stamp = first + static_cast<uint64_t>(k * interval_ns);
+          while (now_ns(base) < stamp && phase.load(std::memory_order_relaxed) != 2) {
+            atomic::detail::cpu_relax();
+          }
+        } else {
+          stamp = now_ns(base);
+        }
+        while (!q->try_enqueue(stamp)) {
+          if (phase.load(std::memory_order_relaxed) == 2) {
+            return;
+          }
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < consumers; ++i) {
+    threads.emplace_back([&, i]() {
+      atomic::pin_thread(cpu_for({}, producers, producers + i));
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      bench::Histogram& hist = hists[i];
+      uint64_t stamp = 0;
+      for (;;) {
+        const int cur_phase = phase.load(std::memory_order_relaxed);
+        if (cur_phase == 2) {
+          break;
+        }
+        if (q->try_dequeue(stamp)) {
+          if (cur_phase == 1) {
+            const uint64_t now = now_ns(base);
+            hist.record(now > stamp ? now - stamp : 0);
+          }
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  start.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  const auto t0 = std::chrono::steady_clock::now();
+  phase.store(1, std::memory_order_relaxed);
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  phase.store(2, std::memory_order_relaxed);
+  const auto t1 = std::chrono::steady_clock::now();
+
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  LatencyResult r{name, {}, std::chrono::duration<double>(t1 - t0).count()};
+  for (const bench::Histogram& h : hists) {
+    r.hist.merge(h);
+  }
+  return r;
+}
+
+static void print_latency(const LatencyResult& r) {
+  std::cout << r.name << ": samples=" << r.hist.count()
+            << " ops/s=" << r.hist.count() / r.seconds
+            << " p50=" << r.hist.percentile(50) << "ns"
+            << " p99=" << r.hist.percentile(99) << "ns"
+            << " p99.9=" << r.hist.percentile(99.9) << "ns"
+            << " max=" << r.hist.max() << "ns\n";
+}
+
+// latency [producers] [consumers] [seconds] [rate per producer, 0 = closed loop]
+static void run_latency_mode(int argc, char** argv) {
+  const int producers = argc >= 3 ? std::atoi(argv[2]) : 1;
+  const int consumers = argc >= 4 ? std::atoi(argv[3]) : 1;
+  const int seconds = argc >= 5 ? std::atoi(argv[4]) : 2;
+  const double rate = argc >= 6 ? std::atof(argv[5]) : 0;
+
+  if (rate > 0) {
+    std::cout << "open loop, " << rate << " ops/s per producer\n";
+  } else {
+    std::cout << "closed loop\n";
+  }
+  print_latency(run_latency<LatMpmcRing>("MpmcRing", producers, consumers, seconds, rate));
+  print_latency(run_latency<LatMutexQueue>("MutexQueue", producers, consumers, seconds, rate));
+  print_latency(run_latency<LatSpscRing>("SpscRing 1P/1C", 1, 1, seconds, rate));
+  print_latency(run_latency<LatMpscRing>("MpscRing NP/1C", producers, 1, seconds, rate));
+}
+
+// Runs every slot layout with 1+1, 2+2, ... producer/consumer pairs up to
+// the hardware thread count.
+static void run_layout_sweep(int seconds) {
+  const int max_threads = std::max(2u, std::thread::hardware_concurrency());
+  for (int pairs = 1; pairs * 2 <= max_threads; pairs *= 2) {
+    std::cout << "threads=" << pairs * 2 << "\n";
+    print_result(run_bench<PackedRing>("  Packed", pairs, pairs, seconds));
+    print_result(run_bench<PaddedRing>("  Padded", pairs, pairs, seconds));
+    print_result(run_bench<RemappedRing>("  Remapped", pairs, pairs, seconds));
+  }
+}
+
+// Runs 1P/1C MPMC and SPSC rings under every named placement the machine
+// supports, so SMT-sibling, same-socket and cross-socket transfers are
+// reported separately instead of mixed together.
+static void run_placements(int seconds) {
+  const atomic::Topology topo = atomic::Topology::detect();
+  std::cout << "cpus=" << topo.cpus().size() << " packages=" << topo.packages() << "\n";
+  const atomic::Placement placements[] = {atomic::Placement::smt_sibling,
+                                          atomic::Placement::same_socket,
+                                          atomic::Placement::cross_socket};
+  for (atomic::Placement p : placements) {
+    const std::vector<int> cpus = topo.assign(p, 1);
+    std::cout << atomic::placement_name(p);
+    if (cpus.empty()) {
+      std::cout << ": not available on this machine\n";
+      continue;
+    }
+    std::cout << " (cpu " << cpus[0] << " -> cpu " << cpus[1] << ")\n";
+    print_result(run_bench<PackedRing>("  MpmcRing 1P/1C", 1, 1, seconds, cpus));
+    print_result(run_bench<SpscRing>("  SpscRing 1P/1C", 1, 1, seconds, cpus));
+  }
 }
 
 int main(int argc, char** argv) {
+  if (argc >= 2 && std::string(argv[1]) == "layouts") {
+    run_layout_sweep(argc >= 3 ? std::atoi(argv[2]) : 2);
+    return 0;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "placements") {
+    run_placements(argc >= 3 ? std::atoi(argv[2]) : 2);
+    return 0;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "latency") {
+    run_latency_mode(argc, argv);
+    return 0;
+  }
+
+  if (!bench::PerfCounters().available()) {
+    std::cerr << "perf counters unavailable; reporting throughput only\n";
+  }
+
   int producers = 4;
   int consumers = 4;
   int seconds = 2;
@@ -164,10 +405,22 @@ int main(int argc, char** argv) {
   if (argc >= 4) seconds = std::atoi(argv[3]);
 
   auto r1 = run_bench<RingQueue>("RingQueue", producers, consumers, seconds);
-  auto r2 = run_bench<MutexQueue>("MutexQueue", producers, consumers, seconds);
+  auto r2 = run_bench<DynRingQueue>("DynRingQueue", producers, consumers, seconds);
+  auto r3 = run_bench<MutexQueue>("MutexQueue", producers, consumers, seconds);
+  // One producer and one consumer regardless of arguments.
+  auto r4 = run_bench<PackedRing>("MpmcRing 1P/1C", 1, 1, seconds);
+  auto r5 = run_bench<SpscRing>("SpscRing 1P/1C", 1, 1, seconds);
+  // Fan-in: all producers, one consumer.
+  auto r6 = run_bench<PackedRing>("MpmcRing NP/1C", producers, 1, seconds);
+  auto r7 = run_bench<MpscRing>("MpscRing NP/1C", producers, 1, seconds);
 
   print_result(r1);
   print_result(r2);
+  print_result(r3);
+  print_result(r4);
+  print_result(r5);
+  print_result(r6);
+  print_result(r7);
 
   return 0;
 }
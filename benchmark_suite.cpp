@@ -0,0 +1,355 @@
+#include "atomic_clamp.hpp"
+#include "atomic_min_max.hpp"
+#include "atomic_queue.hpp"
+#include "bench_histogram.hpp"
+#include "bound_counter.hpp"
+#include "bucket.hpp"
+#include "lfu.hpp"
+#include "rate_limiter_counter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput and latency sweep over every primitive in the library.
+//
+// Usage: benchmark_suite [--csv|--json] [--threads N] [--seconds S] [--only NAME]
+//
+// Each run sweeps 1, 2, 4, ... up to N threads, a "shared" (all threads on
+// one object or a few hot keys) and a "spread" (per-thread objects or a wide
+// key range) contention level, and several payload sizes where the
+// primitive carries data. One op in kSampleEvery is timed individually for
+// the latency percentiles, so the clock does not dominate throughput.
+
+namespace {
+
+constexpr uint64_t kSampleEvery = 16;
+
+struct Result {
+  std::string primitive;
+  std::string contention;
+  std::size_t payload;
+  int threads;
+  uint64_t ops;
+  double seconds;
+  bench::Histogram latency;
+};
+
+struct Options {
+  bool json = false;
+  int max_threads = 0;
+  double seconds = 1.0;
+  std::string only;
+};
+
+template <std::size_t N>
+struct Payload {
+  std::array<unsigned char, N> bytes{};
+};
+
+// Wraps an object on its own cache lines so per-thread copies do not share.
+template <typename T>
+struct alignas(64) Padded {
+  template <typename... Args>
+  explicit Padded(Args&&... args) : value(std::forward<Args>(args)...) {}
+  T value;
+};
+
+template <typename T, typename... Args>
+std::vector<std::unique_ptr<Padded<T>>> make_objects(std::size_t n, Args&&... args) {
+  std::vector<std::unique_ptr<Padded<T>>> out;
+  for (std::size_t i = 0; i < n; ++i) {
+    out.push_back(std::make_unique<Padded<T>>(args...));
+  }
+  return out;
+}
+
+// Runs op(thread, iteration) on `threads` threads for opt.seconds.
+template <typename Op>
+Result run(const Options& opt, const char* primitive, const char* contention,
+           std::size_t payload, int threads, Op op) {
+  std::atomic<bool> start{false};
+  std::atomic<bool> stop{false};
+  std::vector<uint64_t> counts(threads, 0);
+  std::vector<bench::Histogram> hists(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      bench::Histogram& hist = hists[t];
+      uint64_t i = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (i % kSampleEvery == 0) {
+          const auto t0 = std::chrono::steady_clock::now();
+          op(t, i);
+          const auto t1 = std::chrono::steady_clock::now();
+          hist.record(static_cast<uint64_t>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        } else {
+          op(t, i);
+        }
+        ++i;
+      }
+      counts[t] = i;
+    });
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::duration<double>(opt.seconds));
+  stop.store(true, std::memory_order_relaxed);
+  for (auto& w : workers) {
+    w.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - t0;
+
+  Result r{primitive, contention, payload, threads, 0, elapsed.count(), {}};
+  for (int t = 0; t < threads; ++t) {
+    r.ops += counts[t];
+    r.latency.merge(hists[t]);
+  }
+  return r;
+}
+
+void bench_bound_counter(const Options& opt, int threads, std::vector<Result>& out) {
+  using Counter = atomic::BoundCounter<int64_t>;
+  const int64_t cap = std::numeric_limits<int64_t>::max() / 2;
+  {
+    Counter c(cap);
+    out.push_back(run(opt, "BoundCounter", "shared", sizeof(int64_t), threads, [&](int, uint64_t i) {
+      if (i & 1) {
+        (void)c.try_sub(1);
+      } else {
+        (void)c.try_add(1);
+      }
+    }));
+  }
+  auto cs = make_objects<Counter>(threads, cap);
+  out.push_back(run(opt, "BoundCounter", "spread", sizeof(int64_t), threads, [&](int t, uint64_t i) {
+    if (i & 1) {
+      (void)cs[t]->value.try_sub(1);
+    } else {
+      (void)cs[t]->value.try_add(1);
+    }
+  }));
+}
+
+void bench_min_max(const Options& opt, int threads, std::vector<Result>& out) {
+  using MM = atomic::MinMax<int64_t>;
+  {
+    // Strictly rising values keep every update a real CAS.
+    MM mm(0);
+    out.push_back(run(opt, "MinMax", "shared", sizeof(int64_t), threads, [&](int t, uint64_t i) {
+      (void)mm.update_max(static_cast<int64_t>(i * 128 + t));
+    }));
+  }
+  auto ms = make_objects<MM>(threads, 0);
+  out.push_back(run(opt, "MinMax", "spread", sizeof(int64_t), threads, [&](int t, uint64_t i) {
+    (void)ms[t]->value.update_max(static_cast<int64_t>(i));
+  }));
+}
+
+void bench_clamp(const Options& opt, int threads, std::vector<Result>& out) {
+  using C = atomic::Clamp<int64_t>;
+  auto op = [](C& c, uint64_t i) {
+    // Alternate between two disjoint ranges so every call writes.
+    if (i & 1) {
+      c.clamp_to(0, 1);
+    } else {
+      c.clamp_to(10, 11);
+    }
+  };
+  {
+    C c(0);
+    out.push_back(run(opt, "Clamp", "shared", sizeof(int64_t), threads,
+                      [&](int, uint64_t i) { op(c, i); }));
+  }
+  auto cs = make_objects<C>(threads, 0);
+  out.push_back(run(opt, "Clamp", "spread", sizeof(int64_t), threads,
+                    [&](int t, uint64_t i) { op(cs[t]->value, i); }));
+}
+
+void bench_rate_limiter(const Options& opt, int threads, std::vector<Result>& out) {
+  using RL = atomic::RateLimiterCounter;
+  const int limit = std::numeric_limits<int>::max();
+  {
+    RL rl(1, limit);
+    out.push_back(run(opt, "RateLimiterCounter", "shared", 0, threads,
+                      [&](int, uint64_t) { (void)rl.allow(); }));
+  }
+  auto rls = make_objects<RL>(threads, int64_t{1}, limit);
+  out.push_back(run(opt, "RateLimiterCounter", "spread", 0, threads,
+                    [&](int t, uint64_t) { (void)rls[t]->value.allow(); }));
+}
+
+void bench_bucket(const Options& opt, int threads, std::vector<Result>& out) {
+  // Refilled far faster than it can be drained, so consume() always has tokens.
+  {
+    atomic::Bucket b(1, 1e15, 1e15);
+    out.push_back(run(opt, "Bucket", "shared", 0, threads,
+                      [&](int, uint64_t) { (void)b.consume(1.0); }));
+  }
+  auto bs = make_objects<atomic::Bucket>(threads, 1, 1e15, 1e15);
+  out.push_back(run(opt, "Bucket", "spread", 0, threads,
+                    [&](int t, uint64_t) { (void)bs[t]->value.consume(1.0); }));
+}
+
+template <std::size_t N>
+void bench_queue_payload(const Options& opt, int threads, std::vector<Result>& out) {
+  using Q = atomic::Queue<Payload<N>>;
+  auto op = [](Q& q, uint64_t i) {
+    Payload<N> p;
+    p.bytes[0] = static_cast<unsigned char>(i);
+    q.enqueue(p);
+    (void)q.try_dequeue(p);
+  };
+  {
+    Q q;
+    out.push_back(run(opt, "Queue", "shared", N, threads,
+                      [&](int, uint64_t i) { op(q, i); }));
+  }
+  auto qs = make_objects<Q>(threads);
+  out.push_back(run(opt, "Queue", "spread", N, threads,
+                    [&](int t, uint64_t i) { op(qs[t]->value, i); }));
+}
+
+void bench_queue(const Options& opt, int threads, std::vector<Result>& out) {
+  bench_queue_payload<8>(opt, threads, out);
+  bench_queue_payload<64>(opt, threads, out);
+  bench_queue_payload<256>(opt, threads, out);
+}
+
+template <typename Cache, std::size_t N>
+void bench_lfu_payload(const Options& opt, const char* name, int threads,
+                       std::vector<Result>& out) {
+  constexpr std::size_t kCap = 4096;
+  // "shared" hammers 16 hot keys; "spread" walks a range four times the
+  // capacity, so it also exercises eviction. 90% gets, 10% puts.
+  auto run_keys = [&](const char* contention, uint64_t keys) {
+    Cache cache(kCap);
+    for (uint64_t k = 0; k < std::min<uint64_t>(keys, kCap); ++k) {
+      cache.put(k, Payload<N>{});
+    }
+    out.push_back(run(opt, name, contention, N, threads, [&](int t, uint64_t i) {
+      const uint64_t key = (i * 2654435761u + static_cast<uint64_t>(t) * 40503u) % keys;
+      if (i % 10 == 0) {
+        cache.put(key, Payload<N>{});
+      } else {
+        (void)cache.get(key);
+      }
+    }));
+  };
+  run_keys("shared", 16);
+  run_keys("spread", kCap * 4);
+}
+
+void bench_lfu(const Options& opt, int threads, std::vector<Result>& out) {
+  bench_lfu_payload<atomic::LFU<uint64_t, Payload<8>>, 8>(opt, "LFU", threads, out);
+  bench_lfu_payload<atomic::LFU<uint64_t, Payload<256>>, 256>(opt, "LFU", threads, out);
+}
+
+void bench_sharded_lfu(const Options& opt, int threads, std::vector<Result>& out) {
+  bench_lfu_payload<atomic::ShardedLFU<uint64_t, Payload<8>>, 8>(opt, "ShardedLFU", threads, out);
+  bench_lfu_payload<atomic::ShardedLFU<uint64_t, Payload<256>>, 256>(opt, "ShardedLFU", threads,
+                                                                     out);
+}
+
+void print_csv(const std::vector<Result>& results) {
+  std::cout << "primitive,contention,payload_bytes,threads,ops,seconds,ops_per_sec,"
+               "lat_mean_ns,lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p999_ns,lat_max_ns\n";
+  for (const Result& r : results) {
+    std::cout << r.primitive << "," << r.contention << "," << r.payload << ","
+              << r.threads << "," << r.ops << "," << r.seconds << ","
+              << r.ops / r.seconds << "," << r.latency.mean() << ","
+              << r.latency.percentile(50) << "," << r.latency.percentile(90) << ","
+              << r.latency.percentile(99) << "," << r.latency.percentile(99.9) << ","
+              << r.latency.max() << "\n";
+  }
+}
+
+void print_json(const std::vector<Result>& results) {
+  std::cout << "[\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    std::cout << "  {\"primitive\": \"" << r.primitive << "\", \"contention\": \""
+              << r.contention << "\", \"payload_bytes\": " << r.payload
+              << ", \"threads\": " << r.threads << ", \"ops\": " << r.ops
+              << ", \"seconds\": " << r.seconds << ", \"ops_per_sec\": " << r.ops / r.seconds
+              << ", \"latency_ns\": {\"mean\": " << r.latency.mean()
+              << ", \"p50\": " << r.latency.percentile(50)
+              << ", \"p90\": " << r.latency.percentile(90)
+              << ", \"p99\": " << r.latency.percentile(99)
+              << ", \"p999\": " << r.latency.percentile(99.9)
+              << ", \"max\": " << r.latency.max() << "}}"
+              << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  std::cout << "]\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--json") {
+      opt.json = true;
+    } else if (arg == "--csv") {
+      opt.json = false;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      opt.max_threads = std::atoi(argv[++i]);
+    } else if (arg == "--seconds" && i + 1 < argc) {
+      opt.seconds = std::atof(argv[++i]);
+    } else if (arg == "--only" && i + 1 < argc) {
+      opt.only = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--csv|--json] [--threads N] [--seconds S] [--only NAME]\n";
+      return 1;
+    }
+  }
+  if (opt.max_threads <= 0) {
+    opt.max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+
+  using Bench = void (*)(const Options&, int, std::vector<Result>&);
+  const std::pair<const char*, Bench> benches[] = {
+      {"BoundCounter", bench_bound_counter},
+      {"MinMax", bench_min_max},
+      {"Clamp", bench_clamp},
+      {"RateLimiterCounter", bench_rate_limiter},
+      {"Bucket", bench_bucket},
+      {"Queue", bench_queue},
+      {"LFU", bench_lfu},
+      {"ShardedLFU", bench_sharded_lfu},
+  };
+
+  std::vector<Result> results;
+  for (const auto& [name, fn] : benches) {
+    if (!opt.only.empty() && opt.only != name) {
+      continue;
+    }
+    for (int threads = 1; threads <= opt.max_threads; threads *= 2) {
+      fn(opt, threads, results);
+    }
+  }
+
+  if (opt.json) {
+    print_json(results);
+  } else {
+    print_csv(results);
+  }
+  return 0;
+}
@@ -1,10 +1,12 @@
 #ifndef BOUND_COUNTER_HPP
 #define BOUND_COUNTER_HPP
+#include "backoff.hpp"
 #include <atomic>
 #include <type_traits>
 namespace atomic{
 
-template<typename T, typename std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+template<typename T, typename Backoff = backoff::None,
+    typename std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
 class BoundCounter{
 public:
     explicit BoundCounter(T cap):cap_(cap), current_(T{}){}
@@ -33,6 +35,7 @@ public:
             return false;
         }
         T cur = current_.load(std::memory_order_relaxed);
+        Backoff backoff;
         for(;;){
             if(cur > cap_ - val){
                 return false;
@@ -43,6 +46,7 @@ public:
                 std::memory_order_relaxed)){
                 return true;
             }
+            backoff();
         }
     }
     [[nodiscard]] auto try_sub(T val)->bool{
@@ -52,6 +56,7 @@ public:
             }
         }
         T cur = current_.load(std::memory_order_relaxed);
+        Backoff backoff;
         for(;;){
             if(cur < val){
                 return false;
@@ -62,6 +67,7 @@ public:
                 std::memory_order_relaxed)){
                 return true;
             }
+            backoff();
         }
     }
 
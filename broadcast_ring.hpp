@@ -0,0 +1,114 @@
+#ifndef BROADCAST_RING_HPP
+#define BROADCAST_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace atomic{
+
+// Single-producer ring where every consumer sees every element, in the style
+// of the LMAX Disruptor. Each consumer has its own cursor and reads slots in
+// place; the producer may only overwrite a slot once the slowest consumer
+// has moved past it. One ring replaces N copies of the stream.
+template <typename EleType, std::size_t Cap>
+class BroadcastRing{
+private:
+    static constexpr std::size_t kMask = Cap - 1;
+
+public:
+    static_assert((Cap & (Cap - 1)) == 0, "Cap must be power of two.");
+    explicit BroadcastRing(std::size_t consumers)
+        : consumers_(consumers),
+          cursors_(new Cursor[consumers]) {}
+    ~BroadcastRing()=default;
+    BroadcastRing(const BroadcastRing&)=delete;
+    BroadcastRing& operator=(const BroadcastRing&)=delete;
+    BroadcastRing(BroadcastRing&&)=delete;
+    BroadcastRing& operator=(BroadcastRing&&)=delete;
+
+    std::size_t consumers() const{
+        return consumers_;
+    }
+
+    // Producer side; call from one thread only. Fails while the slowest
+    // consumer is a full ring behind.
+    bool try_enqueue(const EleType& ele){
+        return enqueue_impl(ele);
+    }
+    bool try_enqueue(EleType&& ele){
+        return enqueue_impl(std::move(ele));
+    }
+
+    // Consumer side; each index in [0, consumers()) belongs to one thread.
+    bool try_dequeue(std::size_t consumer, EleType& out){
+        const EleType* ele = try_peek(consumer);
+        if(!ele){
+            return false;
+        }
+        out = *ele;
+        release(consumer);
+        return true;
+    }
+    // Next element for this consumer, read in place, or nullptr if it has
+    // caught up. The pointer stays valid until release(consumer).
+    const EleType* try_peek(std::size_t consumer){
+        Cursor& c = cursors_[consumer];
+        const std::size_t pos = c.pos.load(std::memory_order_relaxed);
+        if(pos == c.tail_cache){
+            c.tail_cache = tail_.load(std::memory_order_acquire);
+            if(pos == c.tail_cache){
+                return nullptr;
+            }
+        }
+        return &slots_[pos & kMask];
+    }
+    void release(std::size_t consumer){
+        Cursor& c = cursors_[consumer];
+        c.pos.store(c.pos.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    struct alignas(64) Cursor{
+        std::atomic<std::size_t> pos{0};
+        std::size_t tail_cache{0};
+    };
+
+    template <typename U>
+    bool enqueue_impl(U&& ele){
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - gate_cache_ >= Cap){
+            gate_cache_ = slowest();
+            if(tail - gate_cache_ >= Cap){
+                return false;
+            }
+        }
+        slots_[tail & kMask] = std::forward<U>(ele);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t slowest() const{
+        std::size_t min = tail_.load(std::memory_order_relaxed);
+        for(std::size_t i = 0; i < consumers_; ++i){
+            const std::size_t pos = cursors_[i].pos.load(std::memory_order_acquire);
+            if(pos < min){
+                min = pos;
+            }
+        }
+        return min;
+    }
+
+    const std::size_t consumers_;
+    std::unique_ptr<Cursor[]> cursors_;
+    // Producer line: published tail and the last known slowest cursor.
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t gate_cache_{0};
+    alignas(64) std::array<EleType, Cap> slots_{};
+};
+
+}
+
+#endif
@@ -1,14 +1,16 @@
 #ifndef BUCKET_HPP
 #define BUCKET_HPP
+#include "backoff.hpp"
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <chrono>
 namespace atomic{
 
-class Bucket{
+template <typename Backoff = backoff::None>
+class BasicBucket{
 public:
-    Bucket(int time_mms, double cap, double speed)
+    BasicBucket(int time_mms, double cap, double speed)
 		: stop_(false),
 		time_mms_(time_mms),
 		cap_(cap),
@@ -18,13 +20,13 @@ public:
 			add_spin();
 		});
 	}
-    ~Bucket(){
+    ~BasicBucket(){
 		stop();
 	}
-	Bucket(const Bucket&)=delete;
-	Bucket& operator=(const Bucket&)=delete;
-	Bucket(Bucket&&)=delete;
-	Bucket& operator=(Bucket&&)=delete;
+	BasicBucket(const BasicBucket&)=delete;
+	BasicBucket& operator=(const BasicBucket&)=delete;
+	BasicBucket(BasicBucket&&)=delete;
+	BasicBucket& operator=(BasicBucket&&)=delete;
 
 	[[nodiscard]] double load(std::memory_order order = std::memory_order_relaxed) const{
 		return current_.load(order);
@@ -39,12 +41,14 @@ public:
 			return false;
 		}
 		double cur = current_.load(std::memory_order_relaxed);
+		Backoff backoff;
 		while(cur >=n ){
 			if(current_.compare_exchange_weak(cur, cur - n,
 				std::memory_order_relaxed,
 				std::memory_order_relaxed)){
 				return true;
 			}
+			backoff();
 		}
 		return false;
 	}
@@ -65,6 +69,7 @@ private:
 		const double add_once = speed_ * time_mms_ / 1000.0;
 		for(;!stop_.load(std::memory_order_relaxed);){
 			double cur = current_.load(std::memory_order_relaxed);
+			Backoff backoff;
 			while(cur<cap_){
 				double next = cur + add_once;
 				if(next > cap_){
@@ -75,6 +80,7 @@ private:
 					std::memory_order_relaxed)){
 					break;
 				}
+				backoff();
 			}
 			std::this_thread::sleep_for(std::chrono::milliseconds(time_mms_));
 		}
@@ -88,6 +94,8 @@ private:
 	std::vector<std::thread>add_threads;
 };
 
+using Bucket = BasicBucket<>;
+
 }
 
 
@@ -0,0 +1,129 @@
+#ifndef BYTE_RING_HPP
+#define BYTE_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace atomic{
+namespace SPSC{
+
+// Single-producer single-consumer ring of variable-length byte records.
+// Each record is an 8-byte length header followed by its payload, rounded
+// up to 8 bytes and stored contiguously; when a record would straddle the
+// end of the buffer the producer fills the tail with a padding record and
+// starts again at offset 0. Records are written and read in place:
+//
+//     if(unsigned char* p = ring.reserve(n)){ fill(p, n); ring.commit(); }
+//     std::size_t n;
+//     if(const unsigned char* p = ring.read(n)){ use(p, n); ring.release(); }
+template <std::size_t Cap>
+class ByteRing{
+private:
+    static constexpr std::size_t kMask = Cap - 1;
+    static constexpr std::size_t kHeader = 8;
+    static constexpr uint32_t kPadding = UINT32_MAX;
+
+public:
+    static_assert((Cap & (Cap - 1)) == 0, "Cap must be power of two.");
+    static_assert(Cap >= 4 * kHeader, "Cap is too small.");
+    // Largest payload reserve() accepts. Capping records at half the ring
+    // guarantees one always fits once the ring drains, wherever it wrapped.
+    static constexpr std::size_t kMaxRecord = Cap / 2 - kHeader;
+
+    ByteRing()=default;
+    ~ByteRing()=default;
+    ByteRing(const ByteRing&)=delete;
+    ByteRing& operator=(const ByteRing&)=delete;
+    ByteRing(ByteRing&&)=delete;
+    ByteRing& operator=(ByteRing&&)=delete;
+
+    // Producer side. Returns space for len bytes, or nullptr if the ring is
+    // too full or len > kMaxRecord. Nothing is visible until commit().
+    unsigned char* reserve(std::size_t len){
+        if(len > kMaxRecord){
+            return nullptr;
+        }
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t off = tail & kMask;
+        const std::size_t size = record_size(len);
+        const std::size_t pad = off + size > Cap ? Cap - off : 0;
+        if(Cap - (tail - head_cache_) < pad + size){
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if(Cap - (tail - head_cache_) < pad + size){
+                return nullptr;
+            }
+        }
+        if(pad != 0){
+            write_header(off, kPadding);
+        }
+        reserved_off_ = (tail + pad) & kMask;
+        reserved_len_ = len;
+        reserved_end_ = tail + pad + size;
+        return buf_ + reserved_off_ + kHeader;
+    }
+    // Publishes the record from the last successful reserve().
+    void commit(){
+        write_header(reserved_off_, static_cast<uint32_t>(reserved_len_));
+        tail_.store(reserved_end_, std::memory_order_release);
+    }
+
+    // Consumer side. Returns the next record and its length, or nullptr if
+    // there is none. The bytes stay valid until release().
+    const unsigned char* read(std::size_t& len){
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        for(;;){
+            if(head == tail_cache_){
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if(head == tail_cache_){
+                    return nullptr;
+                }
+            }
+            const std::size_t off = head & kMask;
+            const uint32_t header = read_header(off);
+            if(header == kPadding){
+                head += Cap - off;
+                head_.store(head, std::memory_order_release);
+                continue;
+            }
+            len = header;
+            read_end_ = head + record_size(header);
+            return buf_ + off + kHeader;
+        }
+    }
+    // Frees the record returned by the last successful read().
+    void release(){
+        head_.store(read_end_, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::size_t record_size(std::size_t len){
+        return (kHeader + len + 7) & ~std::size_t{7};
+    }
+    void write_header(std::size_t off, uint32_t len){
+        std::memcpy(buf_ + off, &len, sizeof(len));
+    }
+    uint32_t read_header(std::size_t off) const{
+        uint32_t len;
+        std::memcpy(&len, buf_ + off, sizeof(len));
+        return len;
+    }
+
+    // Producer line.
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_{0};
+    std::size_t reserved_off_{0};
+    std::size_t reserved_len_{0};
+    std::size_t reserved_end_{0};
+    // Consumer line.
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_{0};
+    std::size_t read_end_{0};
+    alignas(64) unsigned char buf_[Cap];
+};
+
+}
+}
+
+#endif
@@ -1,17 +1,23 @@
 #pragma once
 
 #include <cstddef>
-#include <map>
-#include <list>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <algorithm>
 #include <unordered_map>
 #include <mutex>
 #include <utility>
+#include <vector>
 namespace atomic{
 
-template <typename KeyTp, typename ValTp>
+// Least-frequently-used cache; ties are broken by evicting the entry that
+// has gone longest without being touched. All operations are O(1): one
+// hash index owns the entries, and each entry is linked into the bucket of
+// its access count. The buckets form a list in ascending count order, so
+// the eviction victim is always at the front of the first bucket.
+template <typename KeyTp, typename ValTp, typename Hash = std::hash<KeyTp>>
 class LFU{
 public:
     struct LFU_KV{
@@ -32,10 +38,14 @@ public:
               val_(std::move(val)) {}
     };
     explicit LFU(std::size_t cap)
-        : min_freq_(0),
-          cap_(cap),
-          cur_cnt_(0) {}
-    ~LFU()=default;
+        : cap_(cap) {}
+    ~LFU(){
+        while(buckets_){
+            Bucket* next = buckets_->next;
+            delete buckets_;
+            buckets_ = next;
+        }
+    }
     LFU(const LFU&)=delete;
     LFU& operator=(const LFU&)=delete;
     LFU(LFU&&)=delete;
@@ -43,35 +53,12 @@ public:
 
     [[nodiscard]] std::shared_ptr<ValTp> get(const KeyTp& key) {
         std::lock_guard<std::mutex> lock(mu_);
-        auto it = key_to_freq_.find(key);
-        if(it == key_to_freq_.end()){
-            return nullptr;
-        }
-        std::size_t freq = it->second;
-        auto list_it = freq_to_list_.find(freq);
-        if(list_it == freq_to_list_.end()){
-            return nullptr;
-        }
-        auto node_it_it = key_to_iter_.find(key);
-        if(node_it_it == key_to_iter_.end()){
+        auto it = index_.find(key);
+        if(it == index_.end()){
             return nullptr;
         }
-        auto node_it = node_it_it->second;
-        std::shared_ptr<ValTp> out = node_it->val_;
-
-        auto& from = list_it->second;
-        auto& to = freq_to_list_[freq + 1];
-        to.splice(to.end(), from, node_it);
-        key_to_iter_[key] = std::prev(to.end());
-        it->second = freq + 1;
-
-        if(from.empty()){
-            freq_to_list_.erase(list_it);
-            if(min_freq_ == freq){
-                ++min_freq_;
-            }
-        }
-        return out;
+        touch(&*it);
+        return it->second.val;
     }
     bool get(const KeyTp& key, ValTp& out){
         auto ptr = get(key);
@@ -99,34 +86,12 @@ public:
 
     LockedValue get_locked(const KeyTp& key){
         std::unique_lock<std::mutex> lock(mu_);
-        auto it = key_to_freq_.find(key);
-        if(it == key_to_freq_.end()){
+        auto it = index_.find(key);
+        if(it == index_.end()){
             return LockedValue{std::move(lock), nullptr};
         }
-        std::size_t freq = it->second;
-        auto list_it = freq_to_list_.find(freq);
-        if(list_it == freq_to_list_.end()){
-            return LockedValue{std::move(lock), nullptr};
-        }
-        auto node_it_it = key_to_iter_.find(key);
-        if(node_it_it == key_to_iter_.end()){
-            return LockedValue{std::move(lock), nullptr};
-        }
-        auto node_it = node_it_it->second;
-
-        auto& from = list_it->second;
-        auto& to = freq_to_list_[freq + 1];
-        to.splice(to.end(), from, node_it);
-        key_to_iter_[key] = std::prev(to.end());
-        it->second = freq + 1;
-
-        if(from.empty()){
-            freq_to_list_.erase(list_it);
-            if(min_freq_ == freq){
-                ++min_freq_;
-            }
-        }
-        return LockedValue{std::move(lock), node_it->val_};
+        touch(&*it);
+        return LockedValue{std::move(lock), it->second.val};
     }
     void put(const KeyTp& key, const ValTp& val){
         put_impl(key, std::make_shared<ValTp>(val));
@@ -149,6 +114,29 @@ public:
 
 
 private:
+    struct Bucket;
+    struct Node;
+    using Index = std::unordered_map<KeyTp, Node, Hash>;
+    using Entry = typename Index::value_type;
+
+    // Lives inside the index; entries never move, so the links stay valid
+    // across rehashes.
+    struct Node{
+        std::shared_ptr<ValTp> val;
+        Bucket* bucket{nullptr};
+        Entry* prev{nullptr};
+        Entry* next{nullptr};
+    };
+    // All entries with access count freq, oldest first.
+    struct Bucket{
+        std::size_t freq;
+        Entry* head{nullptr};
+        Entry* tail{nullptr};
+        Bucket* prev{nullptr};
+        Bucket* next{nullptr};
+        explicit Bucket(std::size_t f) : freq(f) {}
+    };
+
     template <typename K>
     void put_impl(K&& key, std::shared_ptr<ValTp> val){
         std::lock_guard<std::mutex> lock(mu_);
@@ -158,68 +146,204 @@ private:
         if(!val){
             return;
         }
-        auto it = key_to_freq_.find(key);
-        if(it != key_to_freq_.end()){
-            std::size_t freq = it->second;
-            auto list_it = freq_to_list_.find(freq);
-            if(list_it != freq_to_list_.end()){
-                auto node_it_it = key_to_iter_.find(key);
-                if(node_it_it == key_to_iter_.end()){
-                    return;
-                }
-                auto node_it = node_it_it->second;
-                node_it->val_ = std::move(val);
-                auto& from = list_it->second;
-                auto& to = freq_to_list_[freq + 1];
-                to.splice(to.end(), from, node_it);
-                key_to_iter_[key] = std::prev(to.end());
-                it->second = freq + 1;
-                if(from.empty()){
-                    freq_to_list_.erase(list_it);
-                    if(min_freq_ == freq){
-                        ++min_freq_;
-                    }
-                }
-            }
+        auto [it, inserted] = index_.try_emplace(std::forward<K>(key));
+        Entry* e = &*it;
+        e->second.val = std::move(val);
+        if(!inserted){
+            touch(e);
             return;
         }
+        // The new entry is not linked yet, so it cannot be the victim.
+        if(index_.size() > cap_){
+            evict();
+        }
+        if(!buckets_ || buckets_->freq != 1){
+            try{
+                insert_bucket_after(nullptr, 1);
+            }catch(...){
+                index_.erase(it);
+                throw;
+            }
+        }
+        link(e, buckets_);
+    }
 
-        if(cur_cnt_ >= cap_){
-            auto min_it = freq_to_list_.find(min_freq_);
-            if(min_it != freq_to_list_.end()){
-                auto& lst = min_it->second;
-                auto victim_it = lst.begin();
-                if(victim_it != lst.end()){
-                    key_to_iter_.erase(victim_it->key_);
-                    key_to_freq_.erase(victim_it->key_);
-                    lst.erase(victim_it);
-                    --cur_cnt_;
-                }
-                if(lst.empty()){
-                    freq_to_list_.erase(min_it);
-                }
+    // Moves e from its bucket to the bucket for one more access.
+    void touch(Entry* e){
+        Bucket* from = e->second.bucket;
+        Bucket* to = from->next;
+        if(to == nullptr || to->freq != from->freq + 1){
+            if(from->head == from->tail){
+                // e is alone and the next count is free: bump in place.
+                ++from->freq;
+                return;
             }
+            to = insert_bucket_after(from, from->freq + 1);
+        }
+        unlink(e);
+        link(e, to);
+        if(from->head == nullptr){
+            remove_bucket(from);
+        }
+    }
+
+    void evict(){
+        Bucket* b = buckets_;
+        Entry* victim = b->head;
+        unlink(victim);
+        if(b->head == nullptr){
+            remove_bucket(b);
         }
+        index_.erase(victim->first);
+    }
 
-        auto& lst = freq_to_list_[1];
-        lst.emplace_back(std::forward<K>(key), std::move(val));
-        auto node_it = std::prev(lst.end());
-        key_to_iter_[node_it->key_] = node_it;
-        key_to_freq_[node_it->key_] = 1;
-        min_freq_ = 1;
-        ++cur_cnt_;
+    void link(Entry* e, Bucket* b){
+        Node& n = e->second;
+        n.bucket = b;
+        n.prev = b->tail;
+        n.next = nullptr;
+        if(b->tail){
+            b->tail->second.next = e;
+        }else{
+            b->head = e;
+        }
+        b->tail = e;
+    }
+    void unlink(Entry* e){
+        Node& n = e->second;
+        Bucket* b = n.bucket;
+        if(n.prev){
+            n.prev->second.next = n.next;
+        }else{
+            b->head = n.next;
+        }
+        if(n.next){
+            n.next->second.prev = n.prev;
+        }else{
+            b->tail = n.prev;
+        }
+        n.prev = n.next = nullptr;
     }
 
-    std::map<KeyTp, std::size_t>key_to_freq_;
-    using List = std::list<LFU_KV>;
-    std::unordered_map<std::size_t, List>freq_to_list_;
-    std::map<KeyTp, typename List::iterator>key_to_iter_;
-    std::size_t min_freq_;
+    // Inserts a bucket after pos, or at the front when pos is null.
+    Bucket* insert_bucket_after(Bucket* pos, std::size_t freq){
+        Bucket* b = new Bucket(freq);
+        b->prev = pos;
+        b->next = pos ? pos->next : buckets_;
+        if(b->next){
+            b->next->prev = b;
+        }
+        if(pos){
+            pos->next = b;
+        }else{
+            buckets_ = b;
+        }
+        return b;
+    }
+    void remove_bucket(Bucket* b){
+        if(b->prev){
+            b->prev->next = b->next;
+        }else{
+            buckets_ = b->next;
+        }
+        if(b->next){
+            b->next->prev = b->prev;
+        }
+        delete b;
+    }
+
+    Index index_;
+    // Ascending by freq; the front holds the eviction candidates.
+    Bucket* buckets_{nullptr};
     std::size_t cap_;
-    std::size_t cur_cnt_;
     std::mutex mu_;
 
 
 };
 
+// Drop-in replacement for LFU that spreads keys over independent shards,
+// each an LFU with its own mutex, so operations on different shards never
+// contend. The capacity is split exactly across the shards and each
+// shard evicts on its own, so the cache never holds more than cap entries
+// but the victim is the least frequently used key of its shard, not of
+// the whole cache.
+template <typename KeyTp, typename ValTp, typename Hash = std::hash<KeyTp>>
+class ShardedLFU{
+public:
+    using Shard = LFU<KeyTp, ValTp, Hash>;
+    using LFU_KV = typename Shard::LFU_KV;
+    using LockedValue = typename Shard::LockedValue;
+
+    static constexpr std::size_t kDefaultShards = 16;
+
+    // shards is reduced to cap when cap is smaller, so no shard is left
+    // with zero capacity.
+    explicit ShardedLFU(std::size_t cap, std::size_t shards = kDefaultShards){
+        shards = std::max<std::size_t>(1, std::min(shards, cap));
+        shards_.reserve(shards);
+        for(std::size_t i = 0; i < shards; ++i){
+            shards_.push_back(std::make_unique<Padded>(cap / shards + (i < cap % shards ? 1 : 0)));
+        }
+    }
+    ~ShardedLFU()=default;
+    ShardedLFU(const ShardedLFU&)=delete;
+    ShardedLFU& operator=(const ShardedLFU&)=delete;
+    ShardedLFU(ShardedLFU&&)=delete;
+    ShardedLFU& operator=(ShardedLFU&&)=delete;
+
+    std::size_t shard_count() const noexcept { return shards_.size(); }
+
+    [[nodiscard]] std::shared_ptr<ValTp> get(const KeyTp& key){
+        return shard(key).get(key);
+    }
+    bool get(const KeyTp& key, ValTp& out){
+        return shard(key).get(key, out);
+    }
+    [[nodiscard]] std::optional<ValTp> get_copy(const KeyTp& key){
+        return shard(key).get_copy(key);
+    }
+    // Holds only the lock of the key's shard.
+    LockedValue get_locked(const KeyTp& key){
+        return shard(key).get_locked(key);
+    }
+
+    void put(const KeyTp& key, const ValTp& val){
+        shard(key).put(key, val);
+    }
+    void put(KeyTp&& key, ValTp&& val){
+        Shard& s = shard(key);
+        s.put(std::move(key), std::move(val));
+    }
+    void put(const KeyTp& key, std::shared_ptr<ValTp> val){
+        shard(key).put(key, std::move(val));
+    }
+    void put(KeyTp&& key, std::shared_ptr<ValTp> val){
+        Shard& s = shard(key);
+        s.put(std::move(key), std::move(val));
+    }
+    void put(std::unique_ptr<LFU_KV> kv){
+        if(!kv){
+            return;
+        }
+        Shard& s = shard(kv->key_);
+        s.put(std::move(kv));
+    }
+
+private:
+    // Keeps each shard's mutex off its neighbours' cache lines.
+    struct alignas(64) Padded{
+        explicit Padded(std::size_t cap) : lfu(cap) {}
+        Shard lfu;
+    };
+
+    Shard& shard(const KeyTp& key){
+        // Mix the hash so the shard choice does not reuse the low bits the
+        // shard's own tables index by.
+        const uint64_t h = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return shards_[(h >> 32) % shards_.size()]->lfu;
+    }
+
+    std::vector<std::unique_ptr<Padded>> shards_;
+};
+
 }
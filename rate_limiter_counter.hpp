@@ -1,23 +1,27 @@
 #ifndef RATE_LIMITER_COUNTER_HPP
 #define RATE_LIMITER_COUNTER_HPP
 
+#include "backoff.hpp"
+
 #include <atomic>
 #include <chrono>
 #include <cstdint>
 namespace atomic{
 
-class RateLimiterCounter{
+template <typename Backoff = backoff::None>
+class BasicRateLimiterCounter{
 public:
-    RateLimiterCounter(int64_t window_ms, int limit)
+    BasicRateLimiterCounter(int64_t window_ms, int limit)
       :count_(0), window_start_ms_(0), window_ms_(window_ms), limit_(limit){}
-    ~RateLimiterCounter()=default;
-    RateLimiterCounter(const RateLimiterCounter&)=delete;
-    RateLimiterCounter& operator=(const RateLimiterCounter&)=delete;
-    RateLimiterCounter(RateLimiterCounter&&)=delete;
-    RateLimiterCounter& operator=(RateLimiterCounter&&)=delete;
+    ~BasicRateLimiterCounter()=default;
+    BasicRateLimiterCounter(const BasicRateLimiterCounter&)=delete;
+    BasicRateLimiterCounter& operator=(const BasicRateLimiterCounter&)=delete;
+    BasicRateLimiterCounter(BasicRateLimiterCounter&&)=delete;
+    BasicRateLimiterCounter& operator=(BasicRateLimiterCounter&&)=delete;
 
     [[nodiscard]]bool allow(std::memory_order success = std::memory_order_relaxed,
                std::memory_order failure = std::memory_order_relaxed){
+        Backoff backoff;
         for(;;){
             int64_t now = now_ms();
             int64_t window_start = window_start_ms_.load(failure);
@@ -26,6 +30,7 @@ public:
                     count_.store(1, success);
                     return true;
                 }
+                backoff();
                 now = now_ms();
                 continue;
             }else{
@@ -43,6 +48,7 @@ public:
                     if(count_.compare_exchange_weak(count, count + 1, success, failure)){
                         return true;
                     }
+                    backoff();
                 }
             }
         }
@@ -60,6 +66,8 @@ private:
     int limit_;
 
 };
+
+using RateLimiterCounter = BasicRateLimiterCounter<>;
 }
 
 
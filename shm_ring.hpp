@@ -0,0 +1,206 @@
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+#include "backoff.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace atomic{
+
+// MPMC ring in a POSIX shared memory object, for passing data between
+// processes on one machine. It uses the same per-slot sequence protocol as
+// MPMC::RingBuffer. The mapping holds no pointers, only a header and the
+// slot array at a fixed offset, so every process may map it anywhere.
+//
+// One process create()s the ring; others attach() by name and are refused
+// unless magic, version, element size and capacity all match.
+template <typename EleType, typename Backoff = backoff::None>
+class ShmRingBuffer{
+public:
+    static_assert(std::is_trivially_copyable<EleType>::value,
+        "ShmRingBuffer needs a trivially copyable EleType.");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "ShmRingBuffer needs address-free 64-bit atomics.");
+
+    static constexpr uint64_t kMagic = 0x474e495254414d53ULL;  // "SMATRING"
+    static constexpr uint32_t kVersion = 1;
+
+    // Creates the named object; fails if it already exists. capacity is
+    // rounded up to a power of two. Returns nullptr on any failure.
+    static std::unique_ptr<ShmRingBuffer> create(const char* name, std::size_t capacity){
+        std::size_t cap = 1;
+        while(cap < capacity){
+            cap <<= 1;
+        }
+        const std::size_t bytes = mapping_size(cap);
+        const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if(fd < 0){
+            return nullptr;
+        }
+        void* base = MAP_FAILED;
+        if(ftruncate(fd, static_cast<off_t>(bytes)) == 0){
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if(base == MAP_FAILED){
+            shm_unlink(name);
+            return nullptr;
+        }
+        // The object starts zero-filled; lay out the header and seqs, then
+        // publish magic last so attach() never sees a half-built ring.
+        Header* header = new (base) Header();
+        header->version = kVersion;
+        header->elem_size = static_cast<uint32_t>(sizeof(EleType));
+        header->capacity = cap;
+        Slot* slots = slots_of(base);
+        for(std::size_t i = 0; i < cap; ++i){
+            new (&slots[i]) Slot();
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+        header->magic.store(kMagic, std::memory_order_release);
+        return std::unique_ptr<ShmRingBuffer>(new ShmRingBuffer(base, bytes));
+    }
+
+    // Maps an existing ring. Returns nullptr if it does not exist or was
+    // created with a different layout.
+    static std::unique_ptr<ShmRingBuffer> attach(const char* name){
+        const int fd = shm_open(name, O_RDWR, 0);
+        if(fd < 0){
+            return nullptr;
+        }
+        struct stat st{};
+        if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)){
+            close(fd);
+            return nullptr;
+        }
+        const std::size_t bytes = static_cast<std::size_t>(st.st_size);
+        void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(base == MAP_FAILED){
+            return nullptr;
+        }
+        const Header* header = static_cast<const Header*>(base);
+        const uint64_t cap = header->capacity;
+        if(header->magic.load(std::memory_order_acquire) != kMagic ||
+                header->version != kVersion ||
+                header->elem_size != sizeof(EleType) ||
+                cap == 0 || (cap & (cap - 1)) != 0 ||
+                mapping_size(cap) != bytes){
+            munmap(base, bytes);
+            return nullptr;
+        }
+        return std::unique_ptr<ShmRingBuffer>(new ShmRingBuffer(base, bytes));
+    }
+
+    // Removes the name; mappings already made stay valid.
+    static bool unlink(const char* name){
+        return shm_unlink(name) == 0;
+    }
+
+    ~ShmRingBuffer(){
+        munmap(base_, bytes_);
+    }
+    ShmRingBuffer(const ShmRingBuffer&)=delete;
+    ShmRingBuffer& operator=(const ShmRingBuffer&)=delete;
+
+    std::size_t capacity() const{
+        return mask_ + 1;
+    }
+
+    bool try_enqueue(const EleType& ele){
+        uint64_t pos = header_->tail.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            Slot& slot = slots_[pos & mask_];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if(diff == 0){
+                if(header_->tail.compare_exchange_weak(
+                        pos, pos + 1,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    slot.ele_ = ele;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                backoff();
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = header_->tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    bool try_dequeue(EleType& out){
+        uint64_t pos = header_->head.load(std::memory_order_relaxed);
+        Backoff backoff;
+        for(;;){
+            Slot& slot = slots_[pos & mask_];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+            if(diff == 0){
+                if(header_->head.compare_exchange_weak(
+                        pos, pos + 1,
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed)){
+                    out = slot.ele_;
+                    slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+                backoff();
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = header_->head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Header{
+        std::atomic<uint64_t> magic{0};
+        uint32_t version;
+        uint32_t elem_size;
+        uint64_t capacity;
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+    };
+    struct Slot{
+        std::atomic<uint64_t> seq{0};
+        EleType ele_;
+    };
+
+    static constexpr std::size_t kSlotsOffset = (sizeof(Header) + 63) & ~std::size_t{63};
+
+    static std::size_t mapping_size(std::size_t cap){
+        return kSlotsOffset + cap * sizeof(Slot);
+    }
+    static Slot* slots_of(void* base){
+        return reinterpret_cast<Slot*>(static_cast<unsigned char*>(base) + kSlotsOffset);
+    }
+
+    ShmRingBuffer(void* base, std::size_t bytes)
+        : base_(base),
+          bytes_(bytes),
+          header_(static_cast<Header*>(base)),
+          slots_(slots_of(base)),
+          mask_(header_->capacity - 1) {}
+
+    void* base_;
+    std::size_t bytes_;
+    Header* header_;
+    Slot* slots_;
+    uint64_t mask_;
+};
+
+}
+
+#endif
@@ -2,17 +2,30 @@
 #include "atomic_min_max.hpp"
 #include "atomic_queue.hpp"
 #include "atomic_ring.hpp"
+#include "atomic_segment_queue.hpp"
+#include "atomic_topology.hpp"
 #include "bound_counter.hpp"
+#include "broadcast_ring.hpp"
 #include "bucket.hpp"
+#include "byte_ring.hpp"
 #include "lfu.hpp"
 #include "rate_limiter_counter.hpp"
+#include "shm_ring.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sys/wait.h>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <vector>
@@ -63,6 +76,71 @@ static void test_rate_limiter_counter() {
   assert(rl.allow());
 }
 
+static void test_backoff_policies() {
+  // Same results as the default policy; only the retry pacing differs.
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 5000;
+  BoundCounter<int, backoff::Exponential<>> bc(kThreads * kPerThread);
+  MinMax<int, backoff::Pause> mm(0);
+  Clamp<int, backoff::Exponential<16>> clamp(0);
+  BasicRateLimiterCounter<backoff::Pause> rl(60000, kThreads * kPerThread / 2);
+  std::atomic<int> allowed{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kPerThread; ++i) {
+        assert(bc.try_add(1));
+        (void)mm.update_max(t * kPerThread + i);
+        clamp.clamp_to(i % 7, i % 7 + 1);
+        if (rl.allow()) {
+          allowed.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  assert(bc.load() == kThreads * kPerThread);
+  assert(!bc.try_add(1));
+  assert(mm.load() == kThreads * kPerThread - 1);
+  assert(clamp.load() >= 0 && clamp.load() <= 7);
+  assert(allowed.load() == kThreads * kPerThread / 2);
+
+  Queue<int, backoff::Exponential<>> q;
+  MPMC::RingBuffer<int, 8, MPMC::layout::Packed, backoff::Pause> ring;
+  int out = 0;
+  // Enough nodes to spill the local cache onto the shared free list.
+  for (int i = 0; i < 1000; ++i) {
+    q.enqueue(i);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    assert(q.try_dequeue(out) && out == i);
+  }
+  q.enqueue(1);
+  assert(q.try_dequeue(out) && out == 1);
+  assert(ring.try_enqueue(2) && ring.try_dequeue(out) && out == 2);
+  SegmentQueue<int, 4, backoff::Exponential<>> seg;
+  for (int i = 0; i < 10; ++i) {
+    seg.enqueue(i);
+  }
+  for (int i = 0; i < 10; ++i) {
+    assert(seg.try_dequeue(out) && out == i);
+  }
+  assert(!seg.try_dequeue(out));
+
+  MPMC::DynamicRingBuffer<int, backoff::Exponential<>> dyn(4);
+  assert(dyn.try_enqueue(3) && dyn.try_dequeue(out) && out == 3);
+  MPMC::LossyRingBuffer<int, 4, backoff::Pause> lossy;
+  lossy.enqueue(4);
+  assert(lossy.try_dequeue(out) && out == 4);
+  const std::string name = "/atomiclib_backoff_" + std::to_string(getpid());
+  ShmRingBuffer<int, backoff::Pause>::unlink(name.c_str());
+  auto shm = ShmRingBuffer<int, backoff::Pause>::create(name.c_str(), 4);
+  assert(shm && shm->try_enqueue(5) && shm->try_dequeue(out) && out == 5);
+  ShmRingBuffer<int, backoff::Pause>::unlink(name.c_str());
+}
+
 static void test_atomic_queue() {
   Queue<int> q;
   q.enqueue(1);
@@ -133,6 +211,235 @@ static void test_atomic_queue_concurrent() {
   assert(sum.load() == expected_sum);
 }
 
+static void test_atomic_queue_bulk() {
+  Queue<int> q;
+  std::vector<int> in{1, 2, 3, 4, 5};
+  q.enqueue_bulk(in.begin(), in.end());
+  q.enqueue(6);
+
+  std::vector<int> out;
+  assert(q.try_dequeue_bulk(std::back_inserter(out), 4) == 4);
+  assert(q.try_dequeue_bulk(std::back_inserter(out), 8) == 2);
+  assert(q.try_dequeue_bulk(std::back_inserter(out), 8) == 0);
+  assert((out == std::vector<int>{1, 2, 3, 4, 5, 6}));
+}
+
+// Threads that used a queue exit while it is being destroyed; their cached
+// nodes must not land on the free list after ~Queue drained it (run under
+// ASan to see the leak this guards against).
+static void test_atomic_queue_destroy_during_thread_exit() {
+  for (int round = 0; round < 200; ++round) {
+    auto q = std::make_unique<Queue<int>>();
+    std::atomic<bool> used{false};
+    std::thread worker([&q, &used]() {
+      for (int i = 0; i < 8; ++i) {
+        q->enqueue(i);
+        int out = -1;
+        assert(q->try_dequeue(out));
+      }
+      used.store(true, std::memory_order_release);
+    });
+    while (!used.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    q.reset();
+    worker.join();
+  }
+}
+
+static void test_atomic_queue_thread_churn() {
+  Queue<int> q;
+  for (int round = 0; round < 16; ++round) {
+    std::thread([&q, round]() {
+      for (int i = 0; i < 100; ++i) {
+        q.enqueue(round * 100 + i);
+        int out = -1;
+        assert(q.try_dequeue(out));
+        assert(out == round * 100 + i);
+      }
+    }).join();
+  }
+  // Exited threads left retired nodes behind; further traffic adopts them.
+  for (int i = 0; i < 1000; ++i) {
+    q.enqueue(i);
+    int out = -1;
+    assert(q.try_dequeue(out));
+  }
+
+  // A thread that outlives one queue must not reuse its stale record when
+  // a new queue recycles the same manager id.
+  std::thread worker([]() {
+    for (int round = 0; round < 8; ++round) {
+      Queue<int> scoped;
+      scoped.enqueue(round);
+      int out = -1;
+      assert(scoped.try_dequeue(out));
+      assert(out == round);
+    }
+  });
+  worker.join();
+}
+
+static void test_atomic_queue_blocking() {
+  Queue<int> q;
+  int out = 0;
+  assert(q.dequeue_for(out, std::chrono::milliseconds(5)) == DequeueStatus::empty);
+
+  constexpr int kItems = 1000;
+  long long sum = 0;
+  std::thread consumer([&]() {
+    int value = 0;
+    for (int i = 0; i < kItems; ++i) {
+      q.dequeue_wait(value);
+      sum += value;
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i = 0; i < kItems; ++i) {
+    q.enqueue(i);
+  }
+  consumer.join();
+  assert(sum == static_cast<long long>(kItems) * (kItems - 1) / 2);
+}
+
+static void test_atomic_queue_gauges() {
+  Queue<int> q;
+  assert(q.empty());
+  assert(q.size() == 0);
+  for (int i = 0; i < 200; ++i) {
+    q.enqueue(i);
+  }
+  assert(!q.empty());
+  assert(q.size() == 200);
+
+  std::thread([&q]() {
+    int out = 0;
+    for (int i = 0; i < 150; ++i) {
+      assert(q.try_dequeue(out));
+    }
+  }).join();
+  assert(q.size() == 50);
+
+  int out = 0;
+  while (q.try_dequeue(out)) {
+  }
+  assert(q.empty());
+  assert(q.size() == 0);
+  assert(q.free_list_depth() + q.retired_backlog() <= 200);
+  assert(q.free_list_depth() > 0);
+}
+
+static void test_atomic_queue_close() {
+  Queue<int> q;
+  assert(q.enqueue(1));
+  assert(q.enqueue(2));
+  assert(q.close());
+  assert(!q.close());
+  assert(q.is_closed());
+  assert(!q.enqueue(3));
+
+  int out = 0;
+  assert(q.try_dequeue_status(out) == DequeueStatus::ok && out == 1);
+  assert(q.dequeue_wait(out) && out == 2);
+  assert(q.try_dequeue_status(out) == DequeueStatus::closed);
+  assert(!q.dequeue_wait(out));
+  assert(q.dequeue_for(out, std::chrono::milliseconds(5)) == DequeueStatus::closed);
+  std::vector<int> none;
+  assert(!q.enqueue_bulk(none.begin(), none.end()));
+
+  // The bulk form reports closed only after the last value is taken.
+  Queue<int> bulk;
+  std::vector<int> in{1, 2, 3};
+  assert(bulk.enqueue_bulk(in.begin(), in.end()));
+  std::vector<int> got;
+  std::size_t n = 0;
+  assert(bulk.try_dequeue_bulk_status(std::back_inserter(got), 2, n) == DequeueStatus::ok && n == 2);
+  bulk.close();
+  assert(bulk.try_dequeue_bulk_status(std::back_inserter(got), 2, n) == DequeueStatus::ok && n == 1);
+  assert(bulk.try_dequeue_bulk_status(std::back_inserter(got), 2, n) == DequeueStatus::closed && n == 0);
+  assert((got == std::vector<int>{1, 2, 3}));
+  Queue<int> open;
+  assert(open.try_dequeue_bulk_status(std::back_inserter(got), 2, n) == DequeueStatus::empty && n == 0);
+
+  Queue<int> idle;
+  std::thread waiter([&idle]() {
+    int value = 0;
+    assert(!idle.dequeue_wait(value));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  idle.close();
+  waiter.join();
+}
+
+// Generic producer written against Queue's interface; SegmentQueue must
+// compile and behave the same.
+template <typename Q>
+static bool enqueue_all(Q& q, int n) {
+  for (int i = 0; i < n; ++i) {
+    if (!q.enqueue(std::to_string(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_segment_queue() {
+  SegmentQueue<std::string, 4> q;
+  std::string out;
+  assert(!q.try_dequeue(out));
+  assert(enqueue_all(q, 10));
+  for (int i = 0; i < 10; ++i) {
+    assert(q.try_dequeue(out));
+    assert(out == std::to_string(i));
+  }
+  assert(!q.try_dequeue(out));
+  q.enqueue(std::string("left behind"));
+
+  Queue<std::string> plain;
+  assert(enqueue_all(plain, 3));
+}
+
+static void test_segment_queue_concurrent() {
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+  constexpr int kPerProducer = 20000;
+  constexpr int kTotal = kProducers * kPerProducer;
+
+  SegmentQueue<int, 64> q;
+  std::atomic<int> consumed{0};
+  std::atomic<long long> sum{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([p, &q]() {
+      const int base = p * kPerProducer;
+      for (int i = 0; i < kPerProducer; ++i) {
+        q.enqueue(base + i);
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&]() {
+      int value = 0;
+      while (consumed.load(std::memory_order_relaxed) < kTotal) {
+        if (q.try_dequeue(value)) {
+          sum.fetch_add(value, std::memory_order_relaxed);
+          consumed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  const long long expected_sum = static_cast<long long>(kTotal) * (kTotal - 1) / 2;
+  assert(consumed.load() == kTotal);
+  assert(sum.load() == expected_sum);
+}
+
 static void test_atomic_ring() {
   MPMC::RingBuffer<int, 8> q;
   int out = 0;
@@ -206,6 +513,661 @@ static void test_atomic_ring_concurrent() {
   assert(sum.load() == expected_sum);
 }
 
+static void test_atomic_ring_close() {
+  MPMC::RingBuffer<int, 4> q;
+  assert(q.try_enqueue(1));
+  assert(q.close());
+  assert(!q.close());
+  assert(!q.try_enqueue(2));
+
+  int out = 0;
+  assert(q.try_dequeue_status(out) == DequeueStatus::ok && out == 1);
+  assert(q.try_dequeue_status(out) == DequeueStatus::closed);
+  assert(!q.try_dequeue(out));
+  assert(q.dequeue_for(out, std::chrono::milliseconds(5)) == DequeueStatus::closed);
+
+  MPMC::RingBuffer<int, 4> r;
+  assert(r.dequeue_for(out, std::chrono::milliseconds(5)) == DequeueStatus::empty);
+  std::vector<int> in{1, 2, 3};
+  assert(r.try_enqueue_bulk(in.begin(), in.size()) == 3);
+  r.close();
+  std::vector<int> got;
+  std::size_t n = 0;
+  assert(r.try_dequeue_bulk_status(std::back_inserter(got), 8, n) == DequeueStatus::ok && n == 3);
+  assert(r.try_dequeue_bulk_status(std::back_inserter(got), 8, n) == DequeueStatus::closed && n == 0);
+  assert((got == std::vector<int>{1, 2, 3}));
+}
+
+static void test_atomic_ring_bulk() {
+  MPMC::RingBuffer<int, 8> q;
+  std::vector<int> in{0, 1, 2, 3, 4, 5};
+  assert(q.try_enqueue_bulk(in.begin(), in.size()) == 6);
+  assert(q.try_enqueue_bulk(in.begin(), in.size()) == 2);
+  assert(q.try_enqueue_bulk(in.begin(), 1) == 0);
+
+  std::vector<int> out;
+  assert(q.try_dequeue_bulk(std::back_inserter(out), 3) == 3);
+  assert((out == std::vector<int>{0, 1, 2}));
+  out.clear();
+  assert(q.try_dequeue_bulk(std::back_inserter(out), 100) == 5);
+  assert((out == std::vector<int>{3, 4, 5, 0, 1}));
+  assert(q.try_dequeue_bulk(std::back_inserter(out), 1) == 0);
+  q.close();
+  assert(q.try_enqueue_bulk(in.begin(), 1) == 0);
+
+  // Zero-length calls return at once on an empty and on a full ring.
+  MPMC::RingBuffer<int, 4> z;
+  assert(z.try_enqueue_bulk(in.begin(), 0) == 0);
+  assert(z.try_dequeue_bulk(std::back_inserter(out), 0) == 0);
+  assert(z.try_enqueue_bulk(in.begin(), 4) == 4);
+  assert(z.try_enqueue_bulk(in.begin(), 0) == 0);
+  assert(z.try_dequeue_bulk(std::back_inserter(out), 0) == 0);
+}
+
+static void test_atomic_ring_bulk_concurrent() {
+  constexpr int kProducers = 3;
+  constexpr int kConsumers = 3;
+  constexpr int kPerProducer = 30000;
+  MPMC::RingBuffer<int, 64> q;
+  std::atomic<int> consumed{0};
+  std::vector<std::atomic<int>> seen(kProducers * kPerProducer);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p]() {
+      std::vector<int> batch;
+      for (int i = 0; i < kPerProducer; i += 4) {
+        batch.clear();
+        for (int j = i; j < kPerProducer && j < i + 4; ++j) {
+          batch.push_back(p * kPerProducer + j);
+        }
+        std::size_t done = 0;
+        while (done < batch.size()) {
+          done += q.try_enqueue_bulk(batch.begin() + done, batch.size() - done);
+        }
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&]() {
+      std::vector<int> got;
+      while (consumed.load(std::memory_order_relaxed) < kProducers * kPerProducer) {
+        got.clear();
+        const std::size_t n = q.try_dequeue_bulk(std::back_inserter(got), 5);
+        for (int v : got) {
+          seen[v].fetch_add(1, std::memory_order_relaxed);
+        }
+        consumed.fetch_add(static_cast<int>(n), std::memory_order_relaxed);
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& s : seen) {
+    assert(s.load() == 1);
+  }
+}
+
+static void test_atomic_ring_claim_peek() {
+  struct Msg {
+    int id = 0;
+    char payload[256] = {};
+  };
+  MPMC::RingBuffer<Msg, 2> q;
+  {
+    auto w = q.try_claim();
+    assert(w);
+    w->id = 1;
+    w->payload[255] = 'a';
+    // Nothing is visible until commit.
+    assert(!q.try_peek());
+    w.commit();
+    assert(!w);
+  }
+  {
+    auto w = q.try_claim();
+    w->id = 2;
+  }  // committed by the destructor
+  assert(!q.try_claim());
+
+  {
+    auto r = q.try_peek();
+    assert(r && r->id == 1 && r->payload[255] == 'a');
+    r.release();
+  }
+  Msg m;
+  assert(q.try_dequeue(m) && m.id == 2);
+  assert(!q.try_peek());
+  assert(q.try_claim());
+
+  q.close();
+  assert(!q.try_claim());
+}
+
+template <typename Wait>
+static void check_ring_blocking(int per_producer) {
+  constexpr int kThreads = 2;
+  MPMC::RingBuffer<int, 4> q;
+  std::atomic<long long> sum{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kThreads; ++p) {
+    threads.emplace_back([&]() {
+      for (int i = 1; i <= per_producer; ++i) {
+        assert(q.template enqueue<Wait>(i));
+      }
+    });
+  }
+  for (int c = 0; c < kThreads; ++c) {
+    threads.emplace_back([&]() {
+      int v = 0;
+      while (q.template dequeue<Wait>(v)) {
+        sum.fetch_add(v, std::memory_order_relaxed);
+      }
+    });
+  }
+  for (int p = 0; p < kThreads; ++p) {
+    threads[p].join();
+  }
+  // Consumers parked on the empty ring are released by close().
+  q.close();
+  for (int c = 0; c < kThreads; ++c) {
+    threads[kThreads + c].join();
+  }
+  assert(sum.load() == 1LL * kThreads * per_producer * (per_producer + 1) / 2);
+  assert(!q.template enqueue<Wait>(1));
+}
+
+static void test_atomic_ring_blocking() {
+  // Pure spinners hand over only at the end of a time slice when threads
+  // outnumber cores, so they get a short run.
+  check_ring_blocking<wait::Spin>(200);
+  check_ring_blocking<wait::Backoff>(200);
+  check_ring_blocking<wait::Yield>(20000);
+  check_ring_blocking<wait::Park>(20000);
+
+  Queue<int> q;
+  int out = 0;
+  std::thread producer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.enqueue(7);
+  });
+  assert(q.dequeue_wait<wait::Backoff>(out) && out == 7);
+  producer.join();
+  assert(q.dequeue_for<wait::Yield>(out, std::chrono::milliseconds(5)) == DequeueStatus::empty);
+}
+
+template <typename Layout>
+static void check_ring_layout() {
+  MPMC::RingBuffer<int, 64, Layout> q;
+  int out = 0;
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 64; ++i) {
+      assert(q.try_enqueue(lap * 64 + i));
+    }
+    assert(!q.try_enqueue(-1));
+    for (int i = 0; i < 64; ++i) {
+      assert(q.try_dequeue(out) && out == lap * 64 + i);
+    }
+    assert(!q.try_dequeue(out));
+  }
+}
+
+// Remapped must put neighbouring positions on different cache lines even
+// when the natural slot size (here 8 + 16 = 24 bytes) does not divide 64.
+static void check_remapped_lines() {
+  struct Odd {
+    uint64_t a;
+    uint64_t b;
+  };
+  constexpr std::size_t kSlots = 64;
+  auto ring = std::make_unique<MPMC::RingBuffer<Odd, kSlots, MPMC::layout::Remapped>>();
+  std::vector<uintptr_t> first_line(kSlots);
+  std::vector<uintptr_t> last_line(kSlots);
+  for (std::size_t i = 0; i < kSlots; ++i) {
+    auto h = ring->try_claim();
+    assert(h);
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(&*h);
+    first_line[i] = addr / 64;
+    last_line[i] = (addr + sizeof(Odd) - 1) / 64;
+    h->a = i;
+    h.commit();
+  }
+  for (std::size_t i = 0; i + 1 < kSlots; ++i) {
+    assert(last_line[i] < first_line[i + 1] || last_line[i + 1] < first_line[i]);
+  }
+  Odd out{};
+  for (std::size_t i = 0; i < kSlots; ++i) {
+    assert(ring->try_dequeue(out) && out.a == i);
+  }
+}
+
+static void test_atomic_ring_layouts() {
+  check_remapped_lines();
+  check_ring_layout<MPMC::layout::Packed>();
+  check_ring_layout<MPMC::layout::Padded>();
+  check_ring_layout<MPMC::layout::Remapped>();
+  static_assert(sizeof(MPMC::RingBuffer<int, 64, MPMC::layout::Padded>) >= 64 * 64,
+                "Padded gives each slot a cache line");
+}
+
+static void test_spsc_ring() {
+  SPSC::RingBuffer<int, 8> q;
+  int out = 0;
+  assert(!q.try_dequeue(out));
+  for (int i = 0; i < 8; ++i) {
+    assert(q.try_enqueue(i));
+  }
+  assert(!q.try_enqueue(8));
+  assert(q.try_dequeue(out) && out == 0);
+
+  std::vector<int> batch{10, 11, 12};
+  assert(q.try_enqueue_bulk(batch.begin(), batch.end()) == 1);
+  std::vector<int> drained;
+  assert(q.try_dequeue_bulk(std::back_inserter(drained), 100) == 8);
+  assert(drained.front() == 1 && drained.back() == 10);
+  assert(q.try_enqueue_bulk(batch.begin() + 1, batch.end()) == 2);
+  assert(q.try_dequeue(out) && out == 11);
+  assert(q.try_dequeue(out) && out == 12);
+  assert(!q.try_dequeue(out));
+}
+
+static void test_spsc_ring_concurrent() {
+  constexpr int kItems = 200000;
+  SPSC::RingBuffer<int, 64> q;
+  std::thread producer([&]() {
+    int next = 0;
+    std::vector<int> batch;
+    while (next < kItems) {
+      if (next % 3 == 0) {
+        if (q.try_enqueue(next)) {
+          ++next;
+        }
+      } else {
+        batch.clear();
+        for (int i = next; i < kItems && i < next + 5; ++i) {
+          batch.push_back(i);
+        }
+        next += static_cast<int>(q.try_enqueue_bulk(batch.begin(), batch.end()));
+      }
+    }
+  });
+  int expected = 0;
+  std::vector<int> got;
+  while (expected < kItems) {
+    got.clear();
+    q.try_dequeue_bulk(std::back_inserter(got), 7);
+    for (int v : got) {
+      assert(v == expected);
+      ++expected;
+    }
+    int out = 0;
+    if (expected < kItems && q.try_dequeue(out)) {
+      assert(out == expected);
+      ++expected;
+    }
+  }
+  producer.join();
+}
+
+static void test_mpsc_ring() {
+  MPSC::RingBuffer<int, 4> q;
+  int out = 0;
+  assert(!q.try_dequeue(out));
+  for (int i = 0; i < 4; ++i) {
+    assert(q.try_enqueue(i));
+  }
+  assert(!q.try_enqueue(4));
+  assert(q.try_dequeue(out) && out == 0);
+  assert(q.try_enqueue(4));
+  std::vector<int> drained;
+  assert(q.try_dequeue_bulk(std::back_inserter(drained), 10) == 4);
+  assert((drained == std::vector<int>{1, 2, 3, 4}));
+}
+
+static void test_mpsc_ring_concurrent() {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 20000;
+  MPSC::RingBuffer<int, 16, MPSC::FullPolicy::block> q;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p]() {
+      for (int i = 0; i < kPerProducer; ++i) {
+        assert(q.try_enqueue(p * kPerProducer + i));
+      }
+    });
+  }
+  // Each producer's values must come out in the order it sent them.
+  std::vector<int> last(kProducers, -1);
+  int received = 0;
+  std::vector<int> batch;
+  while (received < kProducers * kPerProducer) {
+    batch.clear();
+    int out = 0;
+    if (q.try_dequeue(out)) {
+      batch.push_back(out);
+    }
+    q.try_dequeue_bulk(std::back_inserter(batch), 8);
+    for (int v : batch) {
+      const int p = v / kPerProducer;
+      assert(v % kPerProducer == last[p] + 1);
+      last[p] = v % kPerProducer;
+      ++received;
+    }
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  assert(!q.try_dequeue(received));
+}
+
+static void test_mpsc_ring_reject_full() {
+  // The consumer never runs, so a producer that claimed a slot past
+  // capacity would wait forever and the joins below would hang.
+  constexpr int kProducers = 8;
+  constexpr int kAttempts = 2000;
+  MPSC::RingBuffer<int, 4> q;
+  std::atomic<bool> go{false};
+  std::atomic<int> accepted{0};
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p]() {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < kAttempts; ++i) {
+        if (q.try_enqueue(p)) {
+          accepted.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+  go.store(true, std::memory_order_release);
+  for (auto& t : producers) {
+    t.join();
+  }
+  assert(accepted.load() == 4);
+  int out = 0;
+  for (int i = 0; i < 4; ++i) {
+    assert(q.try_dequeue(out));
+  }
+  assert(!q.try_dequeue(out));
+  assert(q.try_enqueue(7));
+  assert(q.try_dequeue(out) && out == 7);
+}
+
+static void test_lossy_ring() {
+  MPMC::LossyRingBuffer<int, 4> q;
+  int out = 0;
+  assert(!q.try_dequeue(out));
+  for (int i = 0; i < 10; ++i) {
+    q.enqueue(i);
+  }
+  // Only the newest Cap entries survive.
+  for (int i = 6; i < 10; ++i) {
+    assert(q.try_dequeue(out) && out == i);
+  }
+  assert(!q.try_dequeue(out));
+  assert(q.dropped() == 6);
+}
+
+static void test_lossy_ring_concurrent() {
+  struct Sample {
+    uint64_t value;
+    uint64_t check;
+  };
+  constexpr int kProducers = 2;
+  constexpr int kConsumers = 2;
+  constexpr uint64_t kPerProducer = 50000;
+  MPMC::LossyRingBuffer<Sample, 8> q;
+  std::atomic<int> producers_done{0};
+  std::atomic<uint64_t> consumed{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p]() {
+      for (uint64_t i = 0; i < kPerProducer; ++i) {
+        const uint64_t v = p * kPerProducer + i;
+        q.enqueue(Sample{v, ~v});
+      }
+      producers_done.fetch_add(1);
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&]() {
+      Sample s{};
+      for (;;) {
+        const bool done = producers_done.load() == kProducers;
+        if (q.try_dequeue(s)) {
+          assert(s.check == ~s.value);  // never torn
+          consumed.fetch_add(1);
+        } else if (done) {
+          break;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  assert(consumed.load() + q.dropped() == kProducers * kPerProducer);
+}
+
+static void test_dynamic_ring() {
+  MPMC::DynamicRingBuffer<std::string> q(5, HugePages::transparent);
+  assert(q.capacity() == 8);
+  std::string out;
+  assert(!q.try_dequeue(out));
+  // Several laps so every slot goes through its encoded sequence more than once.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 8; ++i) {
+      assert(q.try_enqueue(std::to_string(lap * 8 + i)));
+    }
+    assert(!q.try_enqueue("full"));
+    for (int i = 0; i < 8; ++i) {
+      assert(q.try_dequeue(out) && out == std::to_string(lap * 8 + i));
+    }
+  }
+  // Leftover elements are destroyed with the ring.
+  assert(q.try_enqueue(std::string(64, 'x')));
+  assert(q.close());
+  assert(!q.try_enqueue("late"));
+  assert(q.try_dequeue_status(out) == DequeueStatus::ok && out.size() == 64);
+  assert(q.try_dequeue_status(out) == DequeueStatus::closed);
+
+  MPMC::DynamicRingBuffer<std::string> leftover(4, HugePages::explicit_tlb);
+  assert(leftover.try_enqueue(std::string(64, 'y')));
+
+  // A zero or unrepresentable capacity must throw, not loop or under-map.
+  auto rejects = [](std::size_t capacity) {
+    try {
+      MPMC::DynamicRingBuffer<int> ring(capacity);
+    } catch (const std::length_error&) {
+      return true;
+    }
+    return false;
+  };
+  assert(rejects(0));
+  assert(rejects(SIZE_MAX / 2 + 2));
+  assert(rejects(SIZE_MAX / 8));
+}
+
+static void test_broadcast_ring() {
+  BroadcastRing<int, 4> q(2);
+  int out = 0;
+  assert(!q.try_dequeue(0, out));
+  for (int i = 0; i < 4; ++i) {
+    assert(q.try_enqueue(i));
+  }
+  assert(!q.try_enqueue(4));
+  // Consumer 0 draining alone does not free a slot; consumer 1 still needs it.
+  for (int i = 0; i < 4; ++i) {
+    assert(q.try_dequeue(0, out) && out == i);
+  }
+  assert(!q.try_enqueue(4));
+  const int* peeked = q.try_peek(1);
+  assert(peeked && *peeked == 0);
+  q.release(1);
+  assert(q.try_enqueue(4));
+  assert(q.try_dequeue(0, out) && out == 4);
+  assert(!q.try_dequeue(0, out));
+}
+
+static void test_broadcast_ring_concurrent() {
+  constexpr int kConsumers = 3;
+  constexpr int kItems = 50000;
+  BroadcastRing<int, 32> q(kConsumers);
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; ++c) {
+    consumers.emplace_back([&, c]() {
+      for (int expected = 0; expected < kItems;) {
+        if (const int* v = q.try_peek(c)) {
+          assert(*v == expected);
+          q.release(c);
+          ++expected;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < kItems;) {
+    if (q.try_enqueue(i)) {
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& t : consumers) {
+    t.join();
+  }
+}
+
+static void test_shm_ring() {
+  const std::string name = "/atomiclib_test_" + std::to_string(getpid());
+  ShmRingBuffer<int>::unlink(name.c_str());
+  auto owner = ShmRingBuffer<int>::create(name.c_str(), 100);
+  assert(owner && owner->capacity() == 128);
+  assert(!ShmRingBuffer<int>::create(name.c_str(), 100));
+  assert(!ShmRingBuffer<double>::attach(name.c_str()));
+  assert(!ShmRingBuffer<int>::attach("/atomiclib_test_missing"));
+
+  // A child process attaches by name and produces; the parent consumes.
+  constexpr int kItems = 10000;
+  const pid_t pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    auto peer = ShmRingBuffer<int>::attach(name.c_str());
+    if (!peer) {
+      _exit(1);
+    }
+    for (int i = 0; i < kItems;) {
+      if (peer->try_enqueue(i)) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    _exit(0);
+  }
+  int out = 0;
+  for (int expected = 0; expected < kItems;) {
+    if (owner->try_dequeue(out)) {
+      assert(out == expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  assert(ShmRingBuffer<int>::unlink(name.c_str()));
+}
+
+static void test_byte_ring() {
+  SPSC::ByteRing<64> q;
+  std::size_t len = 0;
+  assert(!q.read(len));
+  assert(!q.reserve(SPSC::ByteRing<64>::kMaxRecord + 1));
+
+  // 8 + 20 rounds to 32 bytes; two records fill the ring.
+  for (char c : {'a', 'b'}) {
+    unsigned char* p = q.reserve(20);
+    assert(p);
+    std::memset(p, c, 20);
+    q.commit();
+  }
+  assert(!q.reserve(1));
+  const unsigned char* r = q.read(len);
+  assert(r && len == 20 && r[0] == 'a' && r[19] == 'a');
+  q.release();
+
+  // Wraps straight into the space 'a' freed at offset 0.
+  assert(q.reserve(16));
+  q.commit();
+  r = q.read(len);
+  assert(r && len == 20 && r[0] == 'b');
+  q.release();
+  r = q.read(len);
+  assert(r && len == 16);
+  q.release();
+  assert(!q.read(len));
+
+  // Head is now at offset 24. A record at 24 ends at 56; the next one no
+  // longer fits before the end and needs an 8-byte padding record first.
+  assert(q.reserve(20));
+  q.commit();
+  assert(!q.reserve(20));
+  r = q.read(len);
+  assert(r && len == 20);
+  q.release();
+  unsigned char* p = q.reserve(20);
+  assert(p);
+  p[0] = 'c';
+  q.commit();
+  r = q.read(len);
+  assert(r && len == 20 && r[0] == 'c');
+  q.release();
+  assert(!q.read(len));
+}
+
+static void test_byte_ring_concurrent() {
+  constexpr int kRecords = 50000;
+  SPSC::ByteRing<1024> q;
+  std::thread producer([&]() {
+    for (int i = 0; i < kRecords;) {
+      const std::size_t len = static_cast<std::size_t>(i % 97) + 1;
+      if (unsigned char* p = q.reserve(len)) {
+        for (std::size_t j = 0; j < len; ++j) {
+          p[j] = static_cast<unsigned char>(i + j);
+        }
+        q.commit();
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < kRecords;) {
+    std::size_t len = 0;
+    if (const unsigned char* p = q.read(len)) {
+      assert(len == static_cast<std::size_t>(i % 97) + 1);
+      for (std::size_t j = 0; j < len; ++j) {
+        assert(p[j] == static_cast<unsigned char>(i + j));
+      }
+      q.release();
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
 static void test_bucket() {
   Bucket b(10, 5.0, 5.0);
   assert(!b.consume(1.0));
@@ -242,6 +1204,42 @@ static void test_bucket_concurrent() {
   assert(consumed.load() == kTotalTokens);
 }
 
+static void test_topology() {
+  // Fake sysfs: two packages of two cores with two hardware threads each,
+  // one NUMA node per package.
+  namespace fs = std::filesystem;
+  const fs::path root = fs::temp_directory_path() / "atomiclib_topology_test";
+  fs::remove_all(root);
+  auto write = [](const fs::path& path, const std::string& text) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << text << "\n";
+  };
+  write(root / "cpu/online", "0-7");
+  for (int cpu = 0; cpu < 8; ++cpu) {
+    const fs::path dir = root / "cpu" / ("cpu" + std::to_string(cpu)) / "topology";
+    write(dir / "core_id", std::to_string((cpu % 4) / 2));
+    write(dir / "physical_package_id", std::to_string(cpu / 4));
+  }
+  write(root / "node/node0/cpulist", "0-3");
+  write(root / "node/node1/cpulist", "4-7");
+
+  const Topology topo = Topology::detect(root.string());
+  fs::remove_all(root);
+  assert(topo.cpus().size() == 8);
+  assert(topo.packages() == 2);
+  assert(topo.cpus()[5].package == 1 && topo.cpus()[5].core == 0 && topo.cpus()[5].node == 1);
+
+  assert((topo.assign(Placement::smt_sibling, 2) == std::vector<int>{0, 1, 2, 3}));
+  assert(topo.assign(Placement::smt_sibling, 5).empty());
+  assert((topo.assign(Placement::same_socket, 2) == std::vector<int>{0, 2, 4, 6}));
+  assert(topo.assign(Placement::same_socket, 3).empty());
+  assert((topo.assign(Placement::cross_socket, 2) == std::vector<int>{0, 4, 2, 6}));
+
+  assert((Topology::parse_cpu_list("0-2,5") == std::vector<int>{0, 1, 2, 5}));
+  assert(Topology::parse_cpu_list("3-1").empty());
+  assert(!Topology::detect(root.string()).cpus().empty());
+}
+
 static void test_lfu_eviction() {
   LFU<int, int> lfu(2);
   lfu.put(1, 10);
@@ -312,15 +1310,153 @@ static void test_lfu_put_kv() {
   assert(v1 && *v1 == 11);
 }
 
+static void test_lfu_matches_reference() {
+  // Naive model: evict the lowest count, oldest touch first.
+  struct Ref {
+    int key;
+    int val;
+    std::size_t freq;
+    std::size_t tick;
+  };
+  const std::size_t cap = 8;
+  LFU<int, int> lfu(cap);
+  std::vector<Ref> ref;
+  std::size_t tick = 0;
+  uint32_t rng = 12345;
+  for (int step = 0; step < 20000; ++step) {
+    rng = rng * 1664525u + 1013904223u;
+    const int key = static_cast<int>((rng >> 16) % 24);
+    auto it = std::find_if(ref.begin(), ref.end(), [&](const Ref& r) { return r.key == key; });
+    if ((rng >> 8) % 3 == 0) {
+      lfu.put(key, step);
+      if (it != ref.end()) {
+        it->val = step;
+        ++it->freq;
+        it->tick = ++tick;
+      } else {
+        if (ref.size() == cap) {
+          auto victim = std::min_element(ref.begin(), ref.end(), [](const Ref& a, const Ref& b) {
+            return a.freq != b.freq ? a.freq < b.freq : a.tick < b.tick;
+          });
+          ref.erase(victim);
+        }
+        ref.push_back(Ref{key, step, 1, ++tick});
+      }
+    } else {
+      auto v = lfu.get(key);
+      if (it != ref.end()) {
+        assert(v && *v == it->val);
+        ++it->freq;
+        it->tick = ++tick;
+      } else {
+        assert(!v);
+      }
+    }
+  }
+}
+
+static void test_sharded_lfu() {
+  ShardedLFU<int, int> lfu(64, 8);
+  assert(lfu.shard_count() == 8);
+  lfu.put(1, 1);
+  auto v1 = lfu.get(1);
+  assert(v1 && *v1 == 1);
+  int out = 0;
+  assert(lfu.get(1, out) && out == 1);
+  lfu.put(1, 10);
+  auto c1 = lfu.get_copy(1);
+  assert(c1 && *c1 == 10);
+  {
+    auto locked = lfu.get_locked(1);
+    assert(locked);
+    locked.value() = 11;
+  }
+  assert(*lfu.get(1) == 11);
+  lfu.put(std::make_unique<ShardedLFU<int, int>::LFU_KV>(2, 22));
+  assert(*lfu.get(2) == 22);
+
+  // The shards' capacities add up to the global one.
+  for (int k = 100; k < 1100; ++k) {
+    lfu.put(k, k);
+  }
+  int cached = 0;
+  for (int k = 100; k < 1100; ++k) {
+    cached += lfu.get(k) ? 1 : 0;
+  }
+  assert(cached > 0 && cached <= 64);
+
+  ShardedLFU<int, int> small(3);
+  assert(small.shard_count() == 3);
+  ShardedLFU<int, int> empty(0);
+  empty.put(1, 1);
+  assert(!empty.get(1));
+}
+
+static void test_sharded_lfu_concurrent() {
+  ShardedLFU<int, int> lfu(256);
+  const int threads = 4;
+  const int per_thread = 20000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      for (int i = 0; i < per_thread; ++i) {
+        const int key = (i * 7 + t) % 512;
+        if (i % 4 == 0) {
+          lfu.put(key, key);
+        } else if (auto v = lfu.get(key)) {
+          assert(*v == key);
+        }
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  int cached = 0;
+  for (int k = 0; k < 512; ++k) {
+    cached += lfu.get(k) ? 1 : 0;
+  }
+  assert(cached <= 256);
+}
+
 int main() {
   test_bound_counter();
   test_atomic_min_max();
   test_atomic_clamp();
   test_rate_limiter_counter();
+  test_backoff_policies();
   test_atomic_queue();
   test_atomic_queue_concurrent();
+  test_atomic_queue_bulk();
+  test_atomic_queue_thread_churn();
+  test_atomic_queue_destroy_during_thread_exit();
+  test_atomic_queue_blocking();
+  test_atomic_queue_gauges();
+  test_atomic_queue_close();
+  test_segment_queue();
+  test_segment_queue_concurrent();
   test_atomic_ring();
   test_atomic_ring_concurrent();
+  test_atomic_ring_close();
+  test_atomic_ring_blocking();
+  test_atomic_ring_bulk();
+  test_atomic_ring_bulk_concurrent();
+  test_atomic_ring_claim_peek();
+  test_atomic_ring_layouts();
+  test_spsc_ring();
+  test_spsc_ring_concurrent();
+  test_mpsc_ring();
+  test_mpsc_ring_concurrent();
+  test_mpsc_ring_reject_full();
+  test_lossy_ring();
+  test_lossy_ring_concurrent();
+  test_dynamic_ring();
+  test_shm_ring();
+  test_byte_ring();
+  test_byte_ring_concurrent();
+  test_broadcast_ring();
+  test_broadcast_ring_concurrent();
+  test_topology();
   test_bucket();
   test_bucket_concurrent();
   test_lfu_eviction();
@@ -328,6 +1464,9 @@ int main() {
   test_lfu_update_existing();
   test_lfu_accessors();
   test_lfu_put_kv();
+  test_lfu_matches_reference();
+  test_sharded_lfu();
+  test_sharded_lfu_concurrent();
 
   std::cout << "PASS\n";
 
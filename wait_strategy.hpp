@@ -0,0 +1,84 @@
+#ifndef WAIT_STRATEGY_HPP
+#define WAIT_STRATEGY_HPP
+#include "atomic_park.hpp"
+#include "backoff.hpp"
+
+#include <cstdint>
+#include <thread>
+
+namespace atomic{
+
+// Wait strategies for the blocking enqueue()/dequeue() calls. A blocking
+// call makes one strategy object and calls idle() after every attempt that
+// could not make progress. idle() gets the container's Parker and a probe
+// that returns true when the state may have moved in the caller's favour
+// since the last attempt; only Park uses them. timeout_ns < 0 means none.
+namespace wait{
+
+// Busy-spin with a pause instruction: lowest wake-up latency, but burns a
+// core per waiter.
+struct Spin{
+    template <typename Probe>
+    void idle(detail::Parker&, Probe&&, int64_t = -1){
+        detail::cpu_relax();
+    }
+};
+
+// Pause-spins with backoff::Exponential, then yields once it has spun
+// kSpinRounds times (1 + 2 + ... + kMaxSpins pauses).
+struct Backoff{
+    static constexpr unsigned kMaxSpins = 1024;
+    static constexpr unsigned kSpinRounds = 11;
+    static_assert(kMaxSpins == 1u << (kSpinRounds - 1), "Last round must reach kMaxSpins.");
+
+    template <typename Probe>
+    void idle(detail::Parker&, Probe&&, int64_t = -1){
+        if(rounds_ >= kSpinRounds){
+            std::this_thread::yield();
+            return;
+        }
+        ++rounds_;
+        spin_();
+    }
+
+private:
+    backoff::Exponential<kMaxSpins> spin_;
+    unsigned rounds_{0};
+};
+
+// Hands the core back to the scheduler on every call.
+struct Yield{
+    template <typename Probe>
+    void idle(detail::Parker&, Probe&&, int64_t = -1){
+        std::this_thread::yield();
+    }
+};
+
+// Spins briefly, then sleeps on the Parker until the other side notifies.
+// Costs nothing to the other side while nobody is asleep.
+struct Park{
+    static constexpr unsigned kSpinBeforePark = 128;
+
+    template <typename Probe>
+    void idle(detail::Parker& parker, Probe&& probe, int64_t timeout_ns = -1){
+        if(spins_ < kSpinBeforePark){
+            ++spins_;
+            detail::cpu_relax();
+            return;
+        }
+        const uint32_t ticket = parker.prepare_wait();
+        if(probe()){
+            parker.cancel_wait();
+            return;
+        }
+        parker.commit_wait(ticket, timeout_ns);
+    }
+
+private:
+    unsigned spins_{0};
+};
+
+}
+}
+
+#endif